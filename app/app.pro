@@ -0,0 +1,24 @@
+TARGET = timeular
+QT += quick
+
+include(../common.pri)
+include(../lib/lib.pri)
+
+SOURCES += \
+        main.cpp
+
+RESOURCES += qml.qrc
+
+# compile the QML ahead of time instead of at every start
+CONFIG += qtquickcompiler
+
+# Additional import path used to resolve QML modules in Qt Creator's code model
+QML_IMPORT_PATH =
+
+# Additional import path used to resolve QML modules just for Qt Quick Designer
+QML_DESIGNER_IMPORT_PATH =
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
@@ -0,0 +1,112 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <QElapsedTimer>
+#include <QGuiApplication>
+#include <QQmlApplicationEngine>
+#include <QQuickWindow>
+#include <QTimer>
+
+#include <processinfo.h>
+#include <startuptrace.h>
+#include <threadedtimeularmanager.h>
+#include <timeularbrokerclient.h>
+#include <timeularmanager.h>
+#include <timeularpool.h>
+
+namespace {
+    ThreadedTimeularManager *s_manager = nullptr;
+
+    QObject *managerSingleton(QQmlEngine *, QJSEngine *)
+    {
+        QQmlEngine::setObjectOwnership(s_manager, QQmlEngine::CppOwnership);
+        return s_manager;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QElapsedTimer startup;
+    startup.start();
+    StartupTrace::start();
+
+    QCoreApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
+
+    QGuiApplication app(argc, argv);
+
+    qRegisterMetaType<TimeularState>();
+    qmlRegisterType<TimeularManager>("Timeular", 1, 0, "TimeularManager");
+    qmlRegisterType<ThreadedTimeularManager>("Timeular", 1, 0, "ThreadedTimeularManager");
+    qmlRegisterType<TimeularPool>("Timeular", 1, 0, "TimeularPool");
+    qmlRegisterType<TimeularBrokerClient>("Timeular", 1, 0, "BrokerClient");
+    qmlRegisterUncreatableType<AdapterBalancer>("Timeular", 1, 0, "AdapterBalancer",
+                                                QStringLiteral("Adapters are owned by a pool"));
+    qmlRegisterUncreatableType<FaceAggregator>("Timeular", 1, 0, "FaceAggregator",
+                                               QStringLiteral("The aggregator is owned by a manager"));
+    qmlRegisterUncreatableType<PresenceTracker>("Timeular", 1, 0, "PresenceTracker",
+                                                QStringLiteral("Presence is tracked by a pool"));
+    qmlRegisterUncreatableType<ScanScheduler>("Timeular", 1, 0, "ScanScheduler",
+                                              QStringLiteral("Schedulers are owned by a manager"));
+    qmlRegisterUncreatableType<TelemetryScheduler>("Timeular", 1, 0, "TelemetryScheduler",
+                                                   QStringLiteral("Schedulers are owned by a manager"));
+    qmlRegisterUncreatableType<TimeularStats>("Timeular", 1, 0, "TimeularStats",
+                                              QStringLiteral("Stats are owned by a manager"));
+    qmlRegisterUncreatableType<TimeularDevice>("Timeular", 1, 0, "TimeularDevice",
+                                               QStringLiteral("Devices are created by TimeularPool"));
+
+    // the radio gets going on its own thread while the QML is compiled, the
+    // manager has to outlive the engine that shares it
+    ThreadedTimeularManager manager;
+    manager.startDiscovery();
+    s_manager = &manager;
+    qmlRegisterSingletonType<ThreadedTimeularManager>("Timeular", 1, 0, "Manager", managerSingleton);
+
+    QQmlApplicationEngine engine;
+    engine.load(QUrl(QStringLiteral("qrc:/main.qml")));
+    if (engine.rootObjects().isEmpty())
+        return -1;
+    StartupTrace::mark(StartupTrace::QmlLoaded);
+
+    if (QQuickWindow *window = qobject_cast<QQuickWindow *>(engine.rootObjects().first())) {
+        QMetaObject::Connection *frame = new QMetaObject::Connection;
+        *frame = QObject::connect(window, &QQuickWindow::frameSwapped, [frame]() {
+            StartupTrace::mark(StartupTrace::FirstFrame);
+            QObject::disconnect(*frame);
+            delete frame;
+        });
+    }
+
+    // nothing below is needed for the first frame
+    QTimer::singleShot(0, [&startup]() {
+        qInfo().nospace() << "Started in " << startup.elapsed() << " ms, resident memory "
+                          << ProcessInfo::residentMemory() / 1024 << " kB";
+    });
+
+    return app.exec();
+}
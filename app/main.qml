@@ -37,32 +37,21 @@ Window {
     height: 480
     title: qsTr("Hello World")
 
-    TimeularManager {
-        id: tm
-    }
-
     Text {
         anchors.centerIn: parent
         anchors.verticalCenterOffset: 30
-        text: {
-            if(tm.status == TimeularManager.Connecting)
-                return "Connecting"
-            if(tm.status == TimeularManager.Connected)
-                return "Connected"
-            return "Disconnected"
-        }
+        text: Manager.state.statusText
     }
     Text {
         anchors.centerIn: parent
         font.pixelSize: 20
         font.bold: true
-        text: tm.orientation
-        visible: tm.status == TimeularManager.Connected
+        text: Manager.state.orientationText
+        visible: Manager.state.connected
     }
 
     MouseArea {
         anchors.fill: parent
-        onClicked: tm.startDiscovery()
+        onClicked: Manager.startDiscovery()
     }
-    Component.onCompleted: tm.startDiscovery()
 }
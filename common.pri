@@ -0,0 +1,17 @@
+CONFIG += c++11
+
+# The following define makes your compiler emit warnings if you use
+# any Qt feature that has been marked deprecated (the exact warnings
+# depend on your compiler). Refer to the documentation for the
+# deprecated API to know how to port your code away from it.
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# You can also make your code fail to compile if it uses deprecated APIs.
+# In order to do so, uncomment the following line.
+# You can also select to disable deprecated APIs only up to a certain version of Qt.
+#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+# qmake CONFIG+=count_allocations counts every C++ heap allocation, see
+# ProcessInfo::allocations(). Meant for soak runs, it costs an atomic
+# increment per new and delete.
+count_allocations: DEFINES += TIMEULAR_COUNT_ALLOCATIONS
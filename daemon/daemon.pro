@@ -0,0 +1,15 @@
+TARGET = timeulard
+QT = core
+CONFIG += console
+CONFIG -= app_bundle
+
+include(../common.pri)
+include(../lib/lib.pri)
+
+SOURCES += \
+        main.cpp
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
@@ -0,0 +1,214 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QUrl>
+
+#include <eventexporter.h>
+#include <metricsserver.h>
+#include <processinfo.h>
+#include <simulator.h>
+#include <startuptrace.h>
+#include <timeularbroker.h>
+#include <timeularmanager.h>
+#include <timeularpool.h>
+
+namespace {
+    // the exporter outlives the ring it reads, this has to go first
+    class ExporterAttachment
+    {
+    public:
+        ExporterAttachment(EventExporter &exporter, const EventRing *ring)
+            : m_exporter(exporter)
+        {
+            if (!m_exporter.endpoint().isEmpty())
+                m_exporter.attach(ring);
+        }
+        ~ExporterAttachment() { m_exporter.attach(nullptr); }
+
+    private:
+        EventExporter &m_exporter;
+    };
+
+    // virtual dice instead of the radio, to load test the pipeline
+    int runSimulation(QCoreApplication &app, EventExporter &exporter,
+                      int devices, double rate, double dropRate, const QString &replay)
+    {
+        TimeularPool pool;
+        pool.setMaxPendingConnections(devices);
+        const ExporterAttachment attachment(exporter, pool.eventRing());
+
+        Simulator simulator;
+        simulator.attach(&pool, devices);
+        simulator.setRate(rate);
+        simulator.setDropRate(dropRate);
+        if (!replay.isEmpty() && !simulator.setReplayLog(replay))
+            return 1;
+        simulator.start();
+
+        QElapsedTimer interval;
+        interval.start();
+        quint64 lastPublished = 0;
+        QTimer report;
+        QObject::connect(&report, &QTimer::timeout, [&]() {
+            const quint64 published = pool.eventRing()->published();
+            qInfo().nospace() << pool.connectedCount() << " connected, "
+                              << (published - lastPublished) * 1000 / quint64(qMax<qint64>(1, interval.restart()))
+                              << " events/s, " << simulator.dropped() << " links dropped, resident memory "
+                              << ProcessInfo::residentMemory() / 1024 << " kB, heap "
+                              << ProcessInfo::heapInUse() / 1024 << " kB";
+            if (ProcessInfo::countsAllocations())
+                qInfo() << "Live allocations" << ProcessInfo::allocations() - ProcessInfo::deallocations();
+            lastPublished = published;
+        });
+        report.start(5000);
+
+        return app.exec();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QElapsedTimer startup;
+    startup.start();
+    StartupTrace::start();
+
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("timeulard"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Headless Timeular ZEI bridge"));
+    parser.addHelpOption();
+    const QCommandLineOption logOption(QStringLiteral("log"),
+                                       QStringLiteral("Append face changes to the session log <file>."),
+                                       QStringLiteral("file"));
+    const QCommandLineOption exportOption(QStringLiteral("export"),
+                                          QStringLiteral("Upload face changes to <url>."),
+                                          QStringLiteral("url"));
+    const QCommandLineOption simulateOption(QStringLiteral("simulate"),
+                                            QStringLiteral("Run <count> simulated dice instead of using the radio."),
+                                            QStringLiteral("count"));
+    const QCommandLineOption rateOption(QStringLiteral("rate"),
+                                        QStringLiteral("Total simulated events per second, 10 by default."),
+                                        QStringLiteral("events"), QStringLiteral("10"));
+    const QCommandLineOption dropRateOption(QStringLiteral("drop-rate"),
+                                            QStringLiteral("Simulated links dropped per second, none by default."),
+                                            QStringLiteral("drops"), QStringLiteral("0"));
+    const QCommandLineOption replayOption(QStringLiteral("replay"),
+                                          QStringLiteral("Replay the session log <file> in the simulation."),
+                                          QStringLiteral("file"));
+    const QCommandLineOption brokerOption(QStringLiteral("broker"),
+                                          QStringLiteral("Share the die with other processes on the local socket <name>."),
+                                          QStringLiteral("name"));
+    const QCommandLineOption metricsOption(QStringLiteral("metrics"),
+                                           QStringLiteral("Serve Prometheus metrics on <port> at /metrics."),
+                                           QStringLiteral("port"));
+    parser.addOption(logOption);
+    parser.addOption(exportOption);
+    parser.addOption(simulateOption);
+    parser.addOption(rateOption);
+    parser.addOption(dropRateOption);
+    parser.addOption(replayOption);
+    parser.addOption(brokerOption);
+    parser.addOption(metricsOption);
+    parser.process(app);
+
+    EventExporter exporter;
+    if (parser.isSet(exportOption))
+        exporter.setEndpoint(QUrl::fromUserInput(parser.value(exportOption)));
+
+    MetricsServer metrics;
+    if (parser.isSet(metricsOption)
+            && !metrics.listen(QHostAddress::Any, quint16(parser.value(metricsOption).toUInt())))
+        return 1;
+
+    if (parser.isSet(simulateOption)) {
+        return runSimulation(app, exporter,
+                             qMax(1, parser.value(simulateOption).toInt()),
+                             parser.value(rateOption).toDouble(),
+                             parser.value(dropRateOption).toDouble(),
+                             parser.value(replayOption));
+    }
+
+    TimeularManager manager;
+    const ExporterAttachment attachment(exporter, manager.eventRing());
+
+    metrics.attach(&manager);
+
+    TimeularBroker broker;
+    if (parser.isSet(brokerOption)) {
+        if (!broker.listen(parser.value(brokerOption)))
+            return 1;
+        broker.attach(&manager);
+    }
+
+    QObject::connect(&manager, &TimeularManager::statusChanged,
+                     &manager, [&manager](TimeularManager::Status status) {
+                         qInfo() << "Status" << status;
+                         // nobody is around to click, keep trying
+                         if (status == TimeularManager::Disconneted)
+                             QTimer::singleShot(5000, &manager, &TimeularManager::startDiscovery);
+                     });
+    QObject::connect(&manager, &TimeularManager::stableOrientationChanged,
+                     [](TimeularManager::Orientation orientation) {
+                         qInfo() << "Orientation" << orientation;
+                     });
+    QObject::connect(&manager, &TimeularManager::linkRestored,
+                     [](qint64 lostAt, qint64 gap) {
+                         qInfo() << "Link restored after" << gap << "ms, lost at"
+                                 << QDateTime::fromMSecsSinceEpoch(lostAt).toString(Qt::ISODateWithMs);
+                     });
+    QObject::connect(&manager, &TimeularManager::telemetryChanged,
+                     [&manager]() {
+                         static int logged = -1;
+                         if (manager.batteryLevel() != logged) {
+                             logged = manager.batteryLevel();
+                             qInfo() << "Battery" << logged << "%";
+                         }
+                     });
+    QObject::connect(&manager, &TimeularManager::linkProfileChanged,
+                     [](LinkProfile::Profile profile) {
+                         qInfo() << "Link profile" << profile;
+                     });
+    manager.startDiscovery();
+    // replaying the log history can take a while, the radio doesn't have to wait for it
+    if (parser.isSet(logOption))
+        manager.setSessionLog(parser.value(logOption));
+
+    QTimer::singleShot(0, [&startup]() {
+        qInfo().nospace() << "Started in " << startup.elapsed() << " ms, resident memory "
+                          << ProcessInfo::residentMemory() / 1024 << " kB";
+    });
+
+    return app.exec();
+}
@@ -0,0 +1,247 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "adapterbalancer.h"
+#include "devicecache.h"
+#include "scanscheduler.h"
+#include "timeulardevice.h"
+
+#include <QBluetoothDeviceDiscoveryAgent>
+#include <QBluetoothLocalDevice>
+#include <QDebug>
+
+namespace {
+    // stands in for devices that were heard without a usable rssi
+    const qint16 unknownRssi = -100;
+}
+
+AdapterBalancer::AdapterBalancer(QObject *parent)
+    : QObject(parent)
+{
+    const QList<QBluetoothHostInfo> hosts = QBluetoothLocalDevice::allDevices();
+    for (const QBluetoothHostInfo &host : hosts)
+        addAdapter(host.address(), host.name());
+
+    // some platforms don't enumerate adapters, use the default one
+    if (m_adapters.isEmpty())
+        addAdapter(QBluetoothAddress(), QString());
+}
+
+void AdapterBalancer::addAdapter(const QBluetoothAddress &address, const QString &name)
+{
+    const int index = m_adapters.size();
+    Adapter adapter;
+    adapter.address = address;
+    adapter.name = name;
+    adapter.agent = address.isNull() ? new QBluetoothDeviceDiscoveryAgent(this)
+                                     : new QBluetoothDeviceDiscoveryAgent(address, this);
+    adapter.scheduler = new ScanScheduler(adapter.agent, this);
+    connect(adapter.agent, &QBluetoothDeviceDiscoveryAgent::deviceDiscovered,
+            this, [this, index](const QBluetoothDeviceInfo &info) {
+                if (sighted(index, info))
+                    emit deviceDiscovered(info);
+            });
+    connect(adapter.agent, &QBluetoothDeviceDiscoveryAgent::deviceUpdated,
+            this, [this, index](const QBluetoothDeviceInfo &info) {
+                if (sighted(index, info))
+                    emit deviceUpdated(info);
+            });
+    connect(adapter.scheduler, &ScanScheduler::statsChanged,
+            this, &AdapterBalancer::utilizationChanged);
+    m_adapters.append(adapter);
+
+    if (!address.isNull())
+        qDebug() << "Using adapter" << address.toString() << name;
+}
+
+int AdapterBalancer::count() const
+{
+    return m_adapters.size();
+}
+
+QBluetoothAddress AdapterBalancer::address(int adapter) const
+{
+    return m_adapters.value(adapter).address;
+}
+
+ScanScheduler *AdapterBalancer::scheduler(int adapter) const
+{
+    return m_adapters.value(adapter).scheduler;
+}
+
+int AdapterBalancer::maxConnectionsPerAdapter() const
+{
+    return m_maxConnections;
+}
+
+void AdapterBalancer::setMaxConnectionsPerAdapter(int connections)
+{
+    connections = qMax(1, connections);
+    if (connections != m_maxConnections) {
+        m_maxConnections = connections;
+        emit utilizationChanged();
+    }
+}
+
+void AdapterBalancer::setLoadPenalty(int dB)
+{
+    m_loadPenalty = qMax(0, dB);
+}
+
+bool AdapterBalancer::isSighted(const QString &key) const
+{
+    return m_sightings.contains(key);
+}
+
+int AdapterBalancer::pick(const QString &key) const
+{
+    const QVector<qint16> rssi = m_sightings.value(key);
+    int best = -1;
+    int bestScore = 0;
+    for (int i = 0; i < rssi.size(); ++i) {
+        const int current = load(i);
+        if (rssi.at(i) == 0 || current >= m_maxConnections)
+            continue;
+
+        const int score = rssi.at(i) - m_loadPenalty * current;
+        if (best < 0 || score > bestScore) {
+            best = i;
+            bestScore = score;
+        }
+    }
+    return best;
+}
+
+void AdapterBalancer::assign(const QString &key, int adapter)
+{
+    m_assigned.insert(key, adapter);
+    emit utilizationChanged();
+}
+
+void AdapterBalancer::setConnected(const QString &key, bool connected)
+{
+    if (!m_assigned.contains(key))
+        return;
+
+    if (connected)
+        m_connected.insert(key);
+    else
+        m_connected.remove(key);
+    emit utilizationChanged();
+}
+
+void AdapterBalancer::release(const QString &key)
+{
+    if (m_assigned.remove(key) == 0)
+        return;
+
+    m_connected.remove(key);
+    emit utilizationChanged();
+}
+
+QVariantList AdapterBalancer::utilization() const
+{
+    QVariantList result;
+    for (int i = 0; i < m_adapters.size(); ++i) {
+        int connected = 0;
+        int assigned = 0;
+        for (auto it = m_assigned.cbegin(); it != m_assigned.cend(); ++it) {
+            if (it.value() != i)
+                continue;
+            ++assigned;
+            if (m_connected.contains(it.key()))
+                ++connected;
+        }
+        int sightings = 0;
+        for (const QVector<qint16> &rssi : m_sightings) {
+            if (rssi.at(i) != 0)
+                ++sightings;
+        }
+
+        const Adapter &adapter = m_adapters.at(i);
+        QVariantMap entry;
+        entry.insert(QStringLiteral("address"), adapter.address.toString());
+        entry.insert(QStringLiteral("name"), adapter.name);
+        entry.insert(QStringLiteral("connected"), connected);
+        entry.insert(QStringLiteral("connecting"), assigned - connected);
+        entry.insert(QStringLiteral("capacity"), m_maxConnections);
+        entry.insert(QStringLiteral("utilization"), double(assigned) / m_maxConnections);
+        entry.insert(QStringLiteral("sightings"), sightings);
+        entry.insert(QStringLiteral("dutyCycle"), adapter.scheduler->dutyCycle());
+        result.append(entry);
+    }
+    return result;
+}
+
+void AdapterBalancer::start()
+{
+    for (const Adapter &adapter : qAsConst(m_adapters))
+        adapter.scheduler->start();
+}
+
+void AdapterBalancer::stop()
+{
+    for (const Adapter &adapter : qAsConst(m_adapters))
+        adapter.scheduler->stop();
+}
+
+void AdapterBalancer::boost()
+{
+    for (const Adapter &adapter : qAsConst(m_adapters))
+        adapter.scheduler->boost();
+}
+
+void AdapterBalancer::resetBackoff()
+{
+    for (const Adapter &adapter : qAsConst(m_adapters))
+        adapter.scheduler->resetBackoff();
+}
+
+bool AdapterBalancer::sighted(int adapter, const QBluetoothDeviceInfo &info)
+{
+    if (!TimeularDevice::isTimeularDevice(info))
+        return false;
+
+    const QString key = DeviceCache::deviceKey(info.address(), info.deviceUuid());
+    QVector<qint16> &rssi = m_sightings[key];
+    if (rssi.isEmpty())
+        rssi.fill(0, m_adapters.size());
+    rssi[adapter] = info.rssi() < 0 ? info.rssi() : unknownRssi;
+    return true;
+}
+
+int AdapterBalancer::load(int adapter) const
+{
+    int result = 0;
+    for (auto it = m_assigned.cbegin(); it != m_assigned.cend(); ++it) {
+        if (it.value() == adapter)
+            ++result;
+    }
+    return result;
+}
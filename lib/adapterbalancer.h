@@ -0,0 +1,110 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef ADAPTERBALANCER_H
+#define ADAPTERBALANCER_H
+
+#include <QObject>
+#include <QBluetoothAddress>
+#include <QBluetoothDeviceInfo>
+#include <QHash>
+#include <QSet>
+#include <QVariantList>
+#include <QVector>
+
+class QBluetoothDeviceDiscoveryAgent;
+class ScanScheduler;
+
+// Runs discovery on every local adapter and decides which one connects to
+// a device. A single adapter only manages about 7-10 LE links, so devices
+// go to the adapter that hears them best, less a penalty for the links it
+// already carries.
+class AdapterBalancer : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int count READ count CONSTANT)
+    Q_PROPERTY(int maxConnectionsPerAdapter READ maxConnectionsPerAdapter WRITE setMaxConnectionsPerAdapter NOTIFY utilizationChanged)
+public:
+    explicit AdapterBalancer(QObject *parent = nullptr);
+
+    int count() const;
+    QBluetoothAddress address(int adapter) const;
+    ScanScheduler *scheduler(int adapter) const;
+
+    int maxConnectionsPerAdapter() const;
+    void setMaxConnectionsPerAdapter(int connections);
+    // dB an adapter's signal has to be better by to take one more link
+    void setLoadPenalty(int dB);
+
+    // whether any adapter has heard the device, only those are balanced
+    bool isSighted(const QString &key) const;
+    // -1 while every adapter that heard the device is full
+    int pick(const QString &key) const;
+    void assign(const QString &key, int adapter);
+    void setConnected(const QString &key, bool connected);
+    void release(const QString &key);
+
+    // one map per adapter: address, name, connected, connecting, capacity,
+    // utilization, sightings and dutyCycle
+    Q_INVOKABLE QVariantList utilization() const;
+
+public slots:
+    void start();
+    void stop();
+    void boost();
+    void resetBackoff();
+
+signals:
+    void deviceDiscovered(const QBluetoothDeviceInfo &info);
+    // advertisements of a device seen before, mostly rssi changes
+    void deviceUpdated(const QBluetoothDeviceInfo &info);
+    void utilizationChanged();
+
+private:
+    struct Adapter {
+        QBluetoothAddress address;
+        QString name;
+        QBluetoothDeviceDiscoveryAgent *agent = nullptr;
+        ScanScheduler *scheduler = nullptr;
+    };
+
+    void addAdapter(const QBluetoothAddress &address, const QString &name);
+    bool sighted(int adapter, const QBluetoothDeviceInfo &info);
+    int load(int adapter) const;
+
+    QVector<Adapter> m_adapters;
+    // last rssi per adapter for every device heard, 0 for not heard
+    QHash<QString, QVector<qint16>> m_sightings;
+    QHash<QString, int> m_assigned;
+    QSet<QString> m_connected;
+    int m_maxConnections = 7;
+    int m_loadPenalty = 6;
+};
+
+#endif // ADAPTERBALANCER_H
@@ -0,0 +1,334 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "bletransport.h"
+#include "devicecache.h"
+#include "metrics.h"
+
+#include <QDebug>
+#include <QBluetoothUuid>
+
+BleTransport::BleTransport(const QBluetoothDeviceInfo &info, DeviceCache *cache,
+                           const DeviceProfile &profile, QObject *parent)
+    : TimeularTransport(parent)
+    , m_info(info)
+    , m_cache(cache)
+    , m_profile(profile)
+{
+    createController();
+}
+
+BleTransport::~BleTransport()
+{
+    delete m_service;
+    delete m_batteryService;
+}
+
+void BleTransport::createController()
+{
+    // before 5.14 a central can only use the default adapter
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+    if (!m_localAdapter.isNull())
+        m_controller = QLowEnergyController::createCentral(m_info, m_localAdapter, this);
+    else
+#endif
+        m_controller = QLowEnergyController::createCentral(m_info, this);
+    m_controller ->setRemoteAddressType(m_cache->device(m_info.address(), m_info.deviceUuid()).addressType);
+
+    connect(m_controller, &QLowEnergyController::connected,
+            this, &BleTransport::deviceConnected);
+    connect(m_controller, QOverload<QLowEnergyController::Error>::of(&QLowEnergyController::error),
+            this, &BleTransport::errorReceived);
+    connect(m_controller, &QLowEnergyController::disconnected,
+            this, &BleTransport::deviceDisconnected);
+    // failed connection attempts never report disconnected()
+    connect(m_controller, &QLowEnergyController::stateChanged,
+            this, [this](QLowEnergyController::ControllerState state) {
+                if (state == QLowEnergyController::UnconnectedState)
+                    linkDown();
+            });
+    connect(m_controller, &QLowEnergyController::serviceDiscovered,
+            this, &BleTransport::addLowEnergyService);
+    connect(m_controller, &QLowEnergyController::discoveryFinished,
+            this, &BleTransport::serviceScanDone);
+    connect(m_controller, &QLowEnergyController::connectionUpdated,
+            this, &BleTransport::connectionParametersChanged);
+}
+
+void BleTransport::setLocalAdapter(const QBluetoothAddress &adapter)
+{
+    // the controller is bound to its adapter, swap it while there is no link
+    if (m_active || adapter == m_localAdapter)
+        return;
+
+    m_localAdapter = adapter;
+    m_controller->disconnect(this);
+    delete m_controller;
+    createController();
+}
+
+void BleTransport::connectToDevice()
+{
+    if (m_active)
+        return;
+
+    m_active = true;
+    m_attributesCached = m_cache->device(m_info.address(), m_info.deviceUuid()).hasAttributes();
+    m_controller->connectToDevice();
+}
+
+void BleTransport::disconnectFromDevice()
+{
+    m_controller->disconnectFromDevice();
+    linkDown();
+}
+
+void BleTransport::readOrientation()
+{
+    if (!m_service || m_service->state() != QLowEnergyService::ServiceDiscovered)
+        return;
+
+    const QLowEnergyCharacteristic orientationChar = m_service->characteristic(m_profile.orientationCharacteristic);
+    if (orientationChar.isValid())
+        m_service->readCharacteristic(orientationChar);
+}
+
+void BleTransport::readBattery()
+{
+    // not before the orientation subscription is done, it has the ATT queue first
+    if (!m_service || m_service->state() != QLowEnergyService::ServiceDiscovered)
+        return;
+
+    if (!m_batteryService) {
+        m_batteryService = m_controller->createServiceObject(QBluetoothUuid::BatteryService, this);
+        if (!m_batteryService) {
+            qDebug() << "No battery service";
+            return;
+        }
+        connect(m_batteryService, &QLowEnergyService::stateChanged,
+                this, [this](QLowEnergyService::ServiceState state) {
+                    if (state == QLowEnergyService::ServiceDiscovered)
+                        readBatteryLevel();
+                });
+        connect(m_batteryService, &QLowEnergyService::characteristicRead,
+                this, [this](const QLowEnergyCharacteristic &c, const QByteArray &value) {
+                    if (c.uuid() == QBluetoothUuid(QBluetoothUuid::BatteryLevel) && !value.isEmpty())
+                        emit batteryRead(quint8(value.at(0)));
+                });
+    }
+
+    // the details are only discovered once per link
+    if (m_batteryService->state() == QLowEnergyService::DiscoveryRequired)
+        m_batteryService->discoverDetails();
+    else
+        readBatteryLevel();
+}
+
+void BleTransport::readBatteryLevel()
+{
+    if (m_batteryService->state() != QLowEnergyService::ServiceDiscovered)
+        return;
+
+    const QLowEnergyCharacteristic level = m_batteryService->characteristic(QBluetoothUuid::BatteryLevel);
+    if (level.isValid())
+        m_batteryService->readCharacteristic(level);
+}
+
+void BleTransport::requestConnectionParameters(const QLowEnergyConnectionParameters &parameters)
+{
+    // only BlueZ and Android act on this, elsewhere the OS keeps its defaults
+    if (m_controller->state() == QLowEnergyController::UnconnectedState)
+        return;
+    m_controller->requestConnectionUpdate(parameters);
+}
+
+void BleTransport::linkDown()
+{
+    resetService();
+    if (m_active) {
+        m_active = false;
+        emit disconnected();
+    }
+}
+
+void BleTransport::resetService()
+{
+    // may be called from within one of the services' own signals
+    if (m_batteryService) {
+        m_batteryService->disconnect(this);
+        m_batteryService->deleteLater();
+        m_batteryService = nullptr;
+    }
+    if (!m_service)
+        return;
+
+    m_service->disconnect(this);
+    m_service->deleteLater();
+    m_service = nullptr;
+}
+
+void BleTransport::deviceConnected()
+{
+    m_serviceDiscovered = false;
+    emit connected();
+    m_controller->discoverServices();
+}
+
+void BleTransport::deviceDisconnected()
+{
+    linkDown();
+    qDebug() << "Device Disconneted";
+}
+
+void BleTransport::errorReceived(QLowEnergyController::Error /*error*/)
+{
+    Metrics::add(Metrics::ControllerErrors);
+    qWarning() << "Error: " << m_controller->errorString();
+}
+
+void BleTransport::serviceScanDone()
+{
+    // with cached attributes the service is set up as soon as it shows up
+    if (!m_service)
+        setupService();
+}
+
+void BleTransport::setupService()
+{
+    if (m_serviceDiscovered)
+        m_service = m_controller->createServiceObject(m_profile.service, this);
+
+    if (m_service) {
+        connect(m_service, &QLowEnergyService::stateChanged,
+                this, &BleTransport::serviceStateChanged);
+        connect(m_service, &QLowEnergyService::characteristicChanged,
+                this, &BleTransport::deviceDataChanged);
+        connect(m_service, &QLowEnergyService::characteristicRead,
+                this, &BleTransport::deviceDataRead);
+        connect(m_service, &QLowEnergyService::descriptorWritten,
+                this, &BleTransport::confirmedDescriptorWrite);
+        connect(m_service, QOverload<QLowEnergyService::ServiceError>::of(&QLowEnergyService::error),
+                this, &BleTransport::serviceErrorReceived);
+        m_service->discoverDetails();
+    } else {
+        qDebug() << "Service not found";
+        invalidateAttributes();
+        disconnectFromDevice();
+    }
+}
+
+void BleTransport::invalidateAttributes()
+{
+    m_attributesCached = false;
+    m_cache->invalidateAttributes(m_info.address(), m_info.deviceUuid());
+}
+
+void BleTransport::serviceErrorReceived(QLowEnergyService::ServiceError error)
+{
+    Metrics::add(Metrics::ServiceErrors);
+    qWarning() << "Service error: " << error;
+    if (error == QLowEnergyService::DescriptorWriteError)
+        invalidateAttributes();
+}
+
+void BleTransport::confirmedDescriptorWrite(const QLowEnergyDescriptor &d, const QByteArray &value)
+{
+    if (d.isValid() && d == m_notificationDesc && value == QByteArray::fromHex("0000")) {
+        //disabled notifications -> assume disconnect intent
+        disconnectFromDevice();
+    } else if (d.isValid() && d == m_notificationDesc && value == QByteArray::fromHex("0100")) {
+        DeviceCache::Entry entry;
+        entry.address = m_controller->remoteAddress();
+        entry.deviceUuid = m_controller->remoteDeviceUuid();
+        entry.name = m_controller->remoteName();
+        entry.addressType = m_controller->remoteAddressType();
+        entry.characteristicHandle = m_orientationHandle;
+        entry.notificationHandle = m_notificationDesc.handle();
+        m_cache->insert(entry);
+        emit notificationsEnabled();
+    }
+}
+
+void BleTransport::addLowEnergyService(const QBluetoothUuid &serviceUuid)
+{
+    if (serviceUuid == m_profile.service) {
+        m_serviceDiscovered = true;
+        emit serviceDiscovered();
+        // the ZEI GATT table is fixed, no need to wait for the rest of the services
+        if (m_attributesCached && !m_service)
+            setupService();
+    }
+}
+
+void BleTransport::serviceStateChanged(QLowEnergyService::ServiceState newState)
+{
+    switch (newState) {
+    case QLowEnergyService::DiscoveringServices:
+        break;
+    case QLowEnergyService::ServiceDiscovered: {
+        const QLowEnergyCharacteristic orientationChar = m_service->characteristic(m_profile.orientationCharacteristic);
+        if (!orientationChar.isValid()) {
+            qDebug() << "Orientation data not found";
+            invalidateAttributes();
+            disconnectFromDevice();
+            break;
+        }
+
+        emit detailsDiscovered();
+        m_orientationHandle = orientationChar.handle();
+        m_notificationDesc = orientationChar.descriptor(QBluetoothUuid::ClientCharacteristicConfiguration);
+        if (m_notificationDesc.isValid()) {
+            qDebug() << "Device Connected";
+            emit subscribed(m_orientationHandle);
+            m_service->writeDescriptor(m_notificationDesc, QByteArray::fromHex("0100"));
+            // queued right behind the write, so the current face arrives without
+            // waiting for the write to be confirmed or the die to be flipped
+            m_service->readCharacteristic(orientationChar);
+        } else {
+            invalidateAttributes();
+            disconnectFromDevice();
+        }
+
+        break;
+    }
+    default:
+        //nothing for now
+        break;
+    }
+}
+
+void BleTransport::deviceDataChanged(const QLowEnergyCharacteristic &c, const QByteArray &value)
+{
+    emit notificationReceived(c.handle(), value);
+}
+
+void BleTransport::deviceDataRead(const QLowEnergyCharacteristic &c, const QByteArray &value)
+{
+    emit orientationRead(c.handle(), value);
+}
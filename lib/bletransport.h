@@ -27,77 +27,62 @@
   POSSIBILITY OF SUCH DAMAGE.
 */
 
-#ifndef TIMEULARMANAGER_H
-#define TIMEULARMANAGER_H
+#ifndef BLETRANSPORT_H
+#define BLETRANSPORT_H
 
-#include <QObject>
-#include <QBluetoothLocalDevice>
-#include <QBluetoothDeviceDiscoveryAgent>
-#include <QBluetoothServiceDiscoveryAgent>
+#include <QBluetoothDeviceInfo>
 #include <QLowEnergyController>
 
-class TimeularManager : public QObject
+#include "deviceprofile.h"
+#include "timeulartransport.h"
+
+class DeviceCache;
+
+class BleTransport : public TimeularTransport
 {
     Q_OBJECT
-    Q_PROPERTY(Status status READ status NOTIFY statusChanged)
-    Q_PROPERTY(Orientation orientation READ orientation NOTIFY orientationChanged)
 public:
-    enum Status {
-        Disconneted,
-        Connecting,
-        Connected,
-    };
-    Q_ENUMS(Status)
-
-    enum Orientation {
-        Vertical,
-        Face1,
-        Face2,
-        Face3,
-        Face4,
-        Face5,
-        Face6,
-        Face7,
-        Face8
-    };
-    Q_ENUMS(Orientation)
-
-    explicit TimeularManager(QObject *parent = nullptr);
-    ~TimeularManager();
-
-    Status status() const;
-    Orientation orientation() const;
+    BleTransport(const QBluetoothDeviceInfo &info, DeviceCache *cache,
+                 const DeviceProfile &profile = DeviceProfile::of<ZeiProfile>(), QObject *parent = nullptr);
+    ~BleTransport();
 
-public slots:
-    void startDiscovery();
-
-signals:
-    void statusChanged(Status status);
-    void orientationChanged(Orientation orientation);
+    void connectToDevice() override;
+    void disconnectFromDevice() override;
+    void readOrientation() override;
+    void readBattery() override;
+    void setLocalAdapter(const QBluetoothAddress &adapter) override;
+    void requestConnectionParameters(const QLowEnergyConnectionParameters &parameters) override;
 
 private:
-    void setStatus(Status status);
-    void deviceDiscovered(const QBluetoothDeviceInfo &info);
+    void createController();
+    void linkDown();
+    void resetService();
     void addLowEnergyService(const QBluetoothUuid &uuid);
     void deviceConnected();
     void errorReceived(QLowEnergyController::Error);
     void serviceScanDone();
+    void setupService();
+    void invalidateAttributes();
+    void serviceErrorReceived(QLowEnergyService::ServiceError error);
     void deviceDisconnected();
     void serviceStateChanged(QLowEnergyService::ServiceState newState);
     void deviceDataChanged(const QLowEnergyCharacteristic &c, const QByteArray &value);
+    void deviceDataRead(const QLowEnergyCharacteristic &c, const QByteArray &value);
+    void readBatteryLevel();
     void confirmedDescriptorWrite(const QLowEnergyDescriptor &d, const QByteArray &value);
 
-    Status m_status = Disconneted;
+    QBluetoothDeviceInfo m_info;
+    DeviceCache *m_cache;
+    const DeviceProfile &m_profile;
+    QBluetoothAddress m_localAdapter;
+    bool m_active = false;
     bool m_serviceDiscovered = false;
-    QBluetoothDeviceDiscoveryAgent *m_deviceDiscoveryAgent = nullptr;
-    QBluetoothServiceDiscoveryAgent *m_serviceDiscoveryAgent = nullptr;
-    QLowEnergyService *m_service = nullptr;
+    bool m_attributesCached = false;
     QLowEnergyController *m_controller = nullptr;
-    QBluetoothLocalDevice *m_localDevice = nullptr;
+    QLowEnergyService *m_service = nullptr;
+    QLowEnergyService *m_batteryService = nullptr;
     QLowEnergyDescriptor m_notificationDesc;
-    Orientation m_orientation = Vertical;
+    QLowEnergyHandle m_orientationHandle = 0;
 };
 
-
-
-#endif // TIMEULARMANAGER_H
+#endif // BLETRANSPORT_H
@@ -0,0 +1,107 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef BROKERPROTOCOL_H
+#define BROKERPROTOCOL_H
+
+#include <QtEndian>
+#include <cstring>
+
+#include "orientationevent.h"
+
+// Frames sent from a TimeularBroker to its clients, each a type byte and a
+// fixed size little endian body. Events carry the same 16 byte record as
+// the session log. Clients never send anything.
+namespace BrokerProtocol {
+    enum Type : quint8 {
+        Hello = 1,          // magic "ZEIB", quint16 version
+        Status,             // quint64 device id, quint8 TimeularManager::Status
+        Orientation,        // event record, every raw face change
+        StableOrientation   // event record, faces that settled
+    };
+
+    enum {
+        Version = 1,
+        HelloSize = 1 + 4 + 2,
+        StatusSize = 1 + 8 + 1,
+        EventSize = 1 + 16,
+        MaxFrameSize = EventSize
+    };
+
+    // 0 for an unknown type
+    inline int frameSize(quint8 type)
+    {
+        switch (type) {
+        case Hello: return HelloSize;
+        case Status: return StatusSize;
+        case Orientation:
+        case StableOrientation: return EventSize;
+        default: return 0;
+        }
+    }
+
+    inline void encodeHello(uchar *out)
+    {
+        out[0] = Hello;
+        std::memcpy(out + 1, "ZEIB", 4);
+        qToLittleEndian<quint16>(Version, out + 5);
+    }
+
+    inline bool validHello(const uchar *in)
+    {
+        return in[0] == Hello && std::memcmp(in + 1, "ZEIB", 4) == 0
+            && qFromLittleEndian<quint16>(in + 5) == Version;
+    }
+
+    inline void encodeStatus(quint64 deviceId, quint8 status, uchar *out)
+    {
+        out[0] = Status;
+        qToLittleEndian<quint64>(deviceId, out + 1);
+        out[9] = status;
+    }
+
+    inline void encodeEvent(Type type, const OrientationEvent &event, uchar *out)
+    {
+        out[0] = type;
+        qToLittleEndian<qint64>(event.timestamp, out + 1);
+        qToLittleEndian<quint64>((event.deviceId & Q_UINT64_C(0xffffffffffff)) | (quint64(event.face) << 48), out + 9);
+    }
+
+    inline OrientationEvent decodeEvent(const uchar *in)
+    {
+        OrientationEvent event;
+        event.timestamp = qFromLittleEndian<qint64>(in + 1);
+        const quint64 packed = qFromLittleEndian<quint64>(in + 9);
+        event.deviceId = packed & Q_UINT64_C(0xffffffffffff);
+        event.face = quint8(packed >> 48);
+        return event;
+    }
+}
+
+#endif // BROKERPROTOCOL_H
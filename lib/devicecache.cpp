@@ -0,0 +1,147 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "devicecache.h"
+
+#include <QSettings>
+
+namespace {
+    const QLatin1String settingsOrganization("QTimeular");
+    const QLatin1String settingsGroup("Devices");
+    const QLatin1String lastDeviceKey("LastDevice");
+}
+
+QString DeviceCache::deviceKey(const QBluetoothAddress &address, const QBluetoothUuid &deviceUuid)
+{
+    // macOS and iOS never expose the device address, only a per-host uuid
+    return address.isNull() ? deviceUuid.toString() : address.toString();
+}
+
+bool DeviceCache::Entry::isValid() const
+{
+    return !address.isNull() || !deviceUuid.isNull();
+}
+
+bool DeviceCache::Entry::hasAttributes() const
+{
+    return characteristicHandle != 0 && notificationHandle != 0;
+}
+
+QString DeviceCache::Entry::key() const
+{
+    return deviceKey(address, deviceUuid);
+}
+
+QBluetoothDeviceInfo DeviceCache::Entry::deviceInfo() const
+{
+    QBluetoothDeviceInfo info = address.isNull() ? QBluetoothDeviceInfo(deviceUuid, name, 0)
+                                                 : QBluetoothDeviceInfo(address, name, 0);
+    info.setCoreConfigurations(QBluetoothDeviceInfo::LowEnergyCoreConfiguration);
+    return info;
+}
+
+DeviceCache::DeviceCache()
+{
+    QSettings settings(settingsOrganization, settingsOrganization);
+    m_lastDevice = settings.value(lastDeviceKey).toString();
+
+    settings.beginGroup(settingsGroup);
+    const QStringList keys = settings.childGroups();
+    for (const QString &key : keys) {
+        settings.beginGroup(key);
+        Entry entry;
+        entry.address = QBluetoothAddress(settings.value(QLatin1String("address")).toString());
+        entry.deviceUuid = QBluetoothUuid(settings.value(QLatin1String("deviceUuid")).toString());
+        entry.name = settings.value(QLatin1String("name")).toString();
+        if (settings.value(QLatin1String("publicAddress"), false).toBool())
+            entry.addressType = QLowEnergyController::PublicAddress;
+        entry.characteristicHandle = static_cast<QLowEnergyHandle>(settings.value(QLatin1String("characteristicHandle"), 0).toUInt());
+        entry.notificationHandle = static_cast<QLowEnergyHandle>(settings.value(QLatin1String("notificationHandle"), 0).toUInt());
+        settings.endGroup();
+
+        if (entry.isValid())
+            m_entries.insert(entry.key(), entry);
+    }
+}
+
+DeviceCache::Entry DeviceCache::lastDevice() const
+{
+    return m_entries.value(m_lastDevice);
+}
+
+DeviceCache::Entry DeviceCache::device(const QBluetoothAddress &address, const QBluetoothUuid &deviceUuid) const
+{
+    return m_entries.value(deviceKey(address, deviceUuid));
+}
+
+void DeviceCache::insert(const Entry &entry)
+{
+    if (!entry.isValid())
+        return;
+
+    m_entries.insert(entry.key(), entry);
+    m_lastDevice = entry.key();
+    save(entry);
+}
+
+void DeviceCache::invalidateAttributes(const QBluetoothAddress &address, const QBluetoothUuid &deviceUuid)
+{
+    auto it = m_entries.find(deviceKey(address, deviceUuid));
+    if (it == m_entries.end() || !it->hasAttributes())
+        return;
+
+    it->characteristicHandle = 0;
+    it->notificationHandle = 0;
+    save(*it);
+}
+
+void DeviceCache::clear()
+{
+    m_entries.clear();
+    m_lastDevice.clear();
+
+    QSettings settings(settingsOrganization, settingsOrganization);
+    settings.remove(lastDeviceKey);
+    settings.remove(settingsGroup);
+}
+
+void DeviceCache::save(const Entry &entry)
+{
+    QSettings settings(settingsOrganization, settingsOrganization);
+    settings.setValue(lastDeviceKey, m_lastDevice);
+
+    settings.beginGroup(settingsGroup);
+    settings.beginGroup(entry.key());
+    settings.setValue(QLatin1String("address"), entry.address.toString());
+    settings.setValue(QLatin1String("deviceUuid"), entry.deviceUuid.toString());
+    settings.setValue(QLatin1String("name"), entry.name);
+    settings.setValue(QLatin1String("publicAddress"), entry.addressType == QLowEnergyController::PublicAddress);
+    settings.setValue(QLatin1String("characteristicHandle"), entry.characteristicHandle);
+    settings.setValue(QLatin1String("notificationHandle"), entry.notificationHandle);
+}
@@ -0,0 +1,73 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef DEVICECACHE_H
+#define DEVICECACHE_H
+
+#include <QBluetoothAddress>
+#include <QBluetoothDeviceInfo>
+#include <QBluetoothUuid>
+#include <QHash>
+#include <QLowEnergyController>
+
+class DeviceCache
+{
+public:
+    struct Entry {
+        QBluetoothAddress address;
+        QBluetoothUuid deviceUuid;
+        QString name;
+        QLowEnergyController::RemoteAddressType addressType = QLowEnergyController::RandomAddress;
+        QLowEnergyHandle characteristicHandle = 0;
+        QLowEnergyHandle notificationHandle = 0;
+
+        bool isValid() const;
+        bool hasAttributes() const;
+        QString key() const;
+        QBluetoothDeviceInfo deviceInfo() const;
+    };
+
+    DeviceCache();
+
+    static QString deviceKey(const QBluetoothAddress &address, const QBluetoothUuid &deviceUuid);
+
+    Entry lastDevice() const;
+    Entry device(const QBluetoothAddress &address, const QBluetoothUuid &deviceUuid) const;
+    void insert(const Entry &entry);
+    void invalidateAttributes(const QBluetoothAddress &address, const QBluetoothUuid &deviceUuid);
+    void clear();
+
+private:
+    void save(const Entry &entry);
+
+    QHash<QString, Entry> m_entries;
+    QString m_lastDevice;
+};
+
+#endif // DEVICECACHE_H
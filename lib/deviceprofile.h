@@ -0,0 +1,81 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef DEVICEPROFILE_H
+#define DEVICEPROFILE_H
+
+#include <QBluetoothUuid>
+#include <QLatin1String>
+#include <QString>
+#include <QUuid>
+
+// Compile time description of an orientation tracker: where its data lives
+// in the GATT table, how a packet is laid out and how it advertises itself.
+// Everything is a constant, nothing gets parsed at runtime.
+struct ZeiProfile
+{
+    static constexpr QUuid service {
+        0xc7e70010, 0xc847, 0x11e6, 0x81, 0x75, 0x8c, 0x89, 0xa5, 0x5d, 0x40, 0x3c };
+    static constexpr QUuid orientationCharacteristic {
+        0xc7e70012, 0xc847, 0x11e6, 0x81, 0x75, 0x8c, 0x89, 0xa5, 0x5d, 0x40, 0x3c };
+
+    // faces are 1 based, 0 is vertical
+    static constexpr int faceCount = 8;
+    // the face is a single byte at this offset of the characteristic value
+    static constexpr int faceOffset = 0;
+
+    static constexpr const char *advertisedName = "Timeular ZEI";
+    static bool matchesName(const QString &name) { return name == QLatin1String(advertisedName); }
+};
+
+// Runtime handle on a profile for code that can't be a template, such as
+// QObject subclasses. Built once per profile on first use.
+struct DeviceProfile
+{
+    QBluetoothUuid service;
+    QBluetoothUuid orientationCharacteristic;
+    int faceCount;
+    int faceOffset;
+    bool (*matchesName)(const QString &name);
+
+    template <typename Profile>
+    static const DeviceProfile &of()
+    {
+        static const DeviceProfile profile = {
+            QBluetoothUuid(Profile::service),
+            QBluetoothUuid(Profile::orientationCharacteristic),
+            Profile::faceCount,
+            Profile::faceOffset,
+            &Profile::matchesName
+        };
+        return profile;
+    }
+};
+
+#endif // DEVICEPROFILE_H
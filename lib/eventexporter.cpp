@@ -0,0 +1,345 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "eventexporter.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QStandardPaths>
+#include <QTimer>
+
+#include "metrics.h"
+
+namespace {
+    const int minRetryInterval = 5000;
+    const int maxRetryInterval = 5 * 60 * 1000;
+    // a 4096 event ring only overruns at more than 40000 events/s
+    const int drainInterval = 100;
+    const QLatin1String spoolSuffix(".batch");
+    const QLatin1String spoolFilter("*.batch");
+}
+
+EventExporter::EventExporter(QObject *parent)
+    : QObject(parent)
+{
+    m_network = new QNetworkAccessManager(this);
+    m_spoolDirectory = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)
+            + QLatin1String("/spool");
+
+    m_flushTimer = new QTimer(this);
+    m_flushTimer->setInterval(2000);
+    connect(m_flushTimer, &QTimer::timeout, this, &EventExporter::flush);
+    m_flushTimer->start();
+
+    // batches go out every flush interval, but the ring is emptied far more
+    // often so it can't wrap in between
+    m_drainTimer = new QTimer(this);
+    m_drainTimer->setInterval(drainInterval);
+    connect(m_drainTimer, &QTimer::timeout, this, &EventExporter::drainRing);
+
+    m_retryTimer = new QTimer(this);
+    m_retryTimer->setSingleShot(true);
+    connect(m_retryTimer, &QTimer::timeout, this, [this]() {
+        if (!sendSpooled()) {
+            setOnline(true);
+            flush();
+        }
+    });
+}
+
+EventExporter::~EventExporter()
+{
+    drainRing();
+    if (m_inFlight) {
+        m_inFlight->disconnect(this);
+        m_inFlight->abort();
+        if (m_inFlightSpoolFile.isEmpty())
+            spool(m_inFlightPayload, m_inFlightEvents);
+    }
+    while (!m_pending.isEmpty())
+        spoolOverflow();
+}
+
+QUrl EventExporter::endpoint() const
+{
+    return m_endpoint;
+}
+
+void EventExporter::setEndpoint(const QUrl &endpoint)
+{
+    if (endpoint == m_endpoint)
+        return;
+
+    m_endpoint = endpoint;
+    // open the connection now, not with the first batch
+    if (m_endpoint.scheme() == QLatin1String("https"))
+        m_network->connectToHostEncrypted(m_endpoint.host(), quint16(m_endpoint.port(443)));
+    else if (!m_endpoint.isEmpty())
+        m_network->connectToHost(m_endpoint.host(), quint16(m_endpoint.port(80)));
+    emit endpointChanged(m_endpoint);
+}
+
+bool EventExporter::isOnline() const
+{
+    return m_online;
+}
+
+void EventExporter::setBatchSize(int events)
+{
+    m_batchSize = qMax(1, events);
+}
+
+void EventExporter::setFlushInterval(int msecs)
+{
+    m_flushTimer->setInterval(qMax(0, msecs));
+}
+
+void EventExporter::setMaxPendingEvents(int events)
+{
+    m_maxPendingEvents = qMax(1, events);
+}
+
+void EventExporter::setSpoolDirectory(const QString &path)
+{
+    m_spoolDirectory = path;
+}
+
+void EventExporter::attach(const EventRing *ring)
+{
+    // whatever the previous ring still holds is ours, it may be going away
+    drainRing();
+    m_ring = ring;
+    if (m_ring) {
+        m_cursor = m_ring->cursor();
+        m_drainTimer->start();
+    } else {
+        m_drainTimer->stop();
+    }
+}
+
+void EventExporter::append(const OrientationEvent &event)
+{
+    m_pending.append(event);
+    if (m_pending.size() > m_maxPendingEvents)
+        spoolOverflow();
+}
+
+quint64 EventExporter::sentEvents() const
+{
+    return m_sentEvents;
+}
+
+quint64 EventExporter::spooledBatches() const
+{
+    return m_spooledBatches;
+}
+
+quint64 EventExporter::droppedEvents() const
+{
+    return m_droppedEvents;
+}
+
+void EventExporter::flush()
+{
+    drainRing();
+    if (m_inFlight || m_endpoint.isEmpty())
+        return;
+
+    if (!m_online) {
+        // keep memory bounded while the retry timer is waiting
+        while (m_pending.size() >= m_batchSize)
+            spoolOverflow();
+        return;
+    }
+
+    // spooled batches are older, they go first
+    if (sendSpooled())
+        return;
+
+    if (m_pending.isEmpty())
+        return;
+
+    const int count = qMin(m_batchSize, m_pending.size());
+    const QByteArray payload = encode(m_pending.constData(), count);
+    m_pending.remove(0, count);
+    send(payload, count, QString());
+}
+
+void EventExporter::drainRing()
+{
+    if (!m_ring)
+        return;
+
+    OrientationEvent events[64];
+    int count;
+    while ((count = m_ring->drain(m_cursor, events, 64)) > 0) {
+        for (int i = 0; i < count; ++i)
+            append(events[i]);
+    }
+
+    if (m_cursor.overruns) {
+        const quint64 lost = m_cursor.overruns;
+        m_cursor.overruns = 0;
+        m_droppedEvents += lost;
+        Metrics::add(Metrics::ExportDrops, lost);
+        qWarning() << "Exporter fell behind the event ring, lost" << lost << "events";
+        emit droppedEventsChanged(m_droppedEvents);
+    }
+}
+
+QByteArray EventExporter::encode(const OrientationEvent *events, int count) const
+{
+    QJsonArray array;
+    for (int i = 0; i < count; ++i) {
+        QJsonObject object;
+        object.insert(QStringLiteral("time"), events[i].timestamp);
+        object.insert(QStringLiteral("device"), QString::number(events[i].deviceId, 16));
+        object.insert(QStringLiteral("face"), events[i].face);
+        array.append(object);
+    }
+
+    QJsonObject root;
+    root.insert(QStringLiteral("events"), array);
+    // qCompress prepends the uncompressed size to a plain zlib stream
+    return qCompress(QJsonDocument(root).toJson(QJsonDocument::Compact)).mid(4);
+}
+
+void EventExporter::send(const QByteArray &payload, int events, const QString &spoolFile)
+{
+    QNetworkRequest request(m_endpoint);
+    request.setHeader(QNetworkRequest::ContentTypeHeader, QStringLiteral("application/json"));
+    request.setRawHeader("Content-Encoding", "deflate");
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+
+    m_inFlightPayload = payload;
+    m_inFlightEvents = events;
+    m_inFlightSpoolFile = spoolFile;
+    m_inFlightClock.start();
+    m_inFlight = m_network->post(request, payload);
+    connect(m_inFlight, &QNetworkReply::finished, this, &EventExporter::replyFinished);
+}
+
+bool EventExporter::sendSpooled()
+{
+    if (m_inFlight || m_endpoint.isEmpty())
+        return false;
+
+    const QDir dir(m_spoolDirectory);
+    const QStringList files = dir.entryList(QStringList(spoolFilter), QDir::Files, QDir::Name);
+    if (files.isEmpty())
+        return false;
+
+    const QString fileName = dir.filePath(files.first());
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Cannot read spooled batch" << fileName;
+        QFile::remove(fileName);
+        return false;
+    }
+
+    // file names are <sequence>-<event count>.batch
+    const int events = files.first().section(QLatin1Char('-'), 1).section(QLatin1Char('.'), 0, 0).toInt();
+    send(file.readAll(), events, fileName);
+    return true;
+}
+
+void EventExporter::replyFinished()
+{
+    QNetworkReply *reply = m_inFlight;
+    m_inFlight = nullptr;
+    reply->deleteLater();
+
+    if (reply->error() != QNetworkReply::NoError) {
+        qWarning() << "Exporting events failed:" << reply->errorString();
+        if (m_inFlightSpoolFile.isEmpty())
+            spool(m_inFlightPayload, m_inFlightEvents);
+        m_inFlightPayload.clear();
+
+        setOnline(false);
+        m_retryInterval = m_retryInterval ? qMin(maxRetryInterval, m_retryInterval * 2) : minRetryInterval;
+        m_retryTimer->start(m_retryInterval);
+        return;
+    }
+
+    if (!m_inFlightSpoolFile.isEmpty())
+        QFile::remove(m_inFlightSpoolFile);
+    m_sentEvents += quint64(m_inFlightEvents);
+    emit batchSent(m_inFlightEvents, m_inFlightPayload.size(), m_inFlightClock.elapsed());
+    m_inFlightPayload.clear();
+
+    m_retryInterval = 0;
+    setOnline(true);
+
+    // catch up on a backlog without waiting for the next tick
+    if (m_pending.size() >= m_batchSize || !m_inFlightSpoolFile.isEmpty())
+        QTimer::singleShot(0, this, &EventExporter::flush);
+}
+
+void EventExporter::spool(const QByteArray &payload, int events)
+{
+    if (!QDir().mkpath(m_spoolDirectory)) {
+        qWarning() << "Cannot create spool directory" << m_spoolDirectory;
+        return;
+    }
+
+    const QString fileName = QStringLiteral("%1/%2-%3%4")
+            .arg(m_spoolDirectory)
+            .arg(QDateTime::currentMSecsSinceEpoch() * 1000 + qint64(m_spoolSequence++ % 1000), 16, 10, QLatin1Char('0'))
+            .arg(events)
+            .arg(spoolSuffix);
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly) || file.write(payload) != payload.size()) {
+        qWarning() << "Cannot spool batch to" << fileName;
+        return;
+    }
+    ++m_spooledBatches;
+}
+
+void EventExporter::spoolOverflow()
+{
+    const int count = qMin(m_batchSize, m_pending.size());
+    spool(encode(m_pending.constData(), count), count);
+    m_pending.remove(0, count);
+}
+
+void EventExporter::setOnline(bool online)
+{
+    if (online != m_online) {
+        m_online = online;
+        emit onlineChanged(m_online);
+    }
+}
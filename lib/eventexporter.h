@@ -0,0 +1,119 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef EVENTEXPORTER_H
+#define EVENTEXPORTER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QUrl>
+#include <QVector>
+
+#include "eventring.h"
+
+class QNetworkAccessManager;
+class QNetworkReply;
+class QTimer;
+
+// Forwards orientation events to an HTTP endpoint in deflate compressed JSON
+// batches over one keep-alive (HTTP/2 where available) connection. Batches
+// that cannot be delivered are spooled to disk and resent in order.
+class EventExporter : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QUrl endpoint READ endpoint WRITE setEndpoint NOTIFY endpointChanged)
+    Q_PROPERTY(bool online READ isOnline NOTIFY onlineChanged)
+    Q_PROPERTY(quint64 droppedEvents READ droppedEvents NOTIFY droppedEventsChanged)
+public:
+    explicit EventExporter(QObject *parent = nullptr);
+    ~EventExporter();
+
+    QUrl endpoint() const;
+    void setEndpoint(const QUrl &endpoint);
+    bool isOnline() const;
+
+    void setBatchSize(int events);
+    void setFlushInterval(int msecs);
+    // events held in memory before new batches go straight to the spool
+    void setMaxPendingEvents(int events);
+    void setSpoolDirectory(const QString &path);
+
+    // the ring has to outlive the exporter, or be detached with attach(nullptr)
+    void attach(const EventRing *ring);
+    void append(const OrientationEvent &event);
+
+    quint64 sentEvents() const;
+    quint64 spooledBatches() const;
+    // events overwritten in the ring before they could be drained
+    quint64 droppedEvents() const;
+
+public slots:
+    void flush();
+
+signals:
+    void endpointChanged(const QUrl &endpoint);
+    void onlineChanged(bool online);
+    void batchSent(int events, qint64 bytes, qint64 msecs);
+    void droppedEventsChanged(quint64 events);
+
+private:
+    void drainRing();
+    QByteArray encode(const OrientationEvent *events, int count) const;
+    void send(const QByteArray &payload, int events, const QString &spoolFile);
+    bool sendSpooled();
+    void replyFinished();
+    void spool(const QByteArray &payload, int events);
+    void spoolOverflow();
+    void setOnline(bool online);
+
+    QNetworkAccessManager *m_network = nullptr;
+    QTimer *m_flushTimer = nullptr;
+    QTimer *m_drainTimer = nullptr;
+    QTimer *m_retryTimer = nullptr;
+    QUrl m_endpoint;
+    QString m_spoolDirectory;
+    const EventRing *m_ring = nullptr;
+    EventRing::Cursor m_cursor;
+    QVector<OrientationEvent> m_pending;
+    QNetworkReply *m_inFlight = nullptr;
+    QByteArray m_inFlightPayload;
+    QString m_inFlightSpoolFile;
+    int m_inFlightEvents = 0;
+    QElapsedTimer m_inFlightClock;
+    int m_retryInterval = 0;
+    int m_batchSize = 256;
+    int m_maxPendingEvents = 4096;
+    quint64 m_sentEvents = 0;
+    quint64 m_spooledBatches = 0;
+    quint64 m_spoolSequence = 0;
+    quint64 m_droppedEvents = 0;
+    bool m_online = true;
+};
+
+#endif // EVENTEXPORTER_H
@@ -0,0 +1,112 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "eventring.h"
+
+namespace {
+    const quint64 deviceIdMask = Q_UINT64_C(0xffffffffffff);
+
+    quint64 roundUpToPowerOfTwo(quint64 value)
+    {
+        quint64 result = 1;
+        while (result < value)
+            result <<= 1;
+        return result;
+    }
+}
+
+EventRing::EventRing(int capacity)
+    : m_mask(roundUpToPowerOfTwo(quint64(qMax(2, capacity))) - 1)
+{
+    m_slots.reset(new Slot[m_mask + 1]);
+}
+
+void EventRing::publish(const OrientationEvent &event)
+{
+    const quint64 index = m_head.load(std::memory_order_relaxed);
+    Slot &slot = m_slots[index & m_mask];
+
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.timestamp.store(event.timestamp, std::memory_order_relaxed);
+    slot.packed.store((event.deviceId & deviceIdMask) | (quint64(event.face) << 48), std::memory_order_relaxed);
+    slot.sequence.store(index + 1, std::memory_order_release);
+
+    m_head.store(index + 1, std::memory_order_release);
+}
+
+EventRing::Cursor EventRing::cursor() const
+{
+    Cursor cursor;
+    cursor.next = published();
+    return cursor;
+}
+
+bool EventRing::read(Cursor &cursor, OrientationEvent *event) const
+{
+    for (;;) {
+        const quint64 head = published();
+        if (cursor.next >= head)
+            return false;
+
+        const quint64 capacity = m_mask + 1;
+        if (head - cursor.next > capacity) {
+            cursor.overruns += head - capacity - cursor.next;
+            cursor.next = head - capacity;
+        }
+
+        const Slot &slot = m_slots[cursor.next & m_mask];
+        const quint64 before = slot.sequence.load(std::memory_order_acquire);
+        const qint64 timestamp = slot.timestamp.load(std::memory_order_relaxed);
+        const quint64 packed = slot.packed.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const quint64 after = slot.sequence.load(std::memory_order_relaxed);
+
+        if (before != cursor.next + 1 || after != before) {
+            // the producer lapped us while reading, skip ahead and retry
+            ++cursor.overruns;
+            ++cursor.next;
+            continue;
+        }
+
+        event->timestamp = timestamp;
+        event->deviceId = packed & deviceIdMask;
+        event->face = quint8(packed >> 48);
+        ++cursor.next;
+        return true;
+    }
+}
+
+int EventRing::drain(Cursor &cursor, OrientationEvent *events, int max) const
+{
+    int count = 0;
+    while (count < max && read(cursor, events + count))
+        ++count;
+    return count;
+}
@@ -0,0 +1,76 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef EVENTRING_H
+#define EVENTRING_H
+
+#include <QtGlobal>
+
+#include <atomic>
+#include <memory>
+
+#include "orientationevent.h"
+
+// Fixed capacity single producer, multi consumer broadcast ring. The producer
+// never waits: consumers that fall more than capacity() events behind lose
+// the oldest ones and have them counted as overruns on their cursor.
+class EventRing
+{
+public:
+    struct Cursor {
+        quint64 next = 0;
+        quint64 overruns = 0;
+    };
+
+    explicit EventRing(int capacity = 4096);
+
+    int capacity() const { return int(m_mask + 1); }
+    quint64 published() const { return m_head.load(std::memory_order_acquire); }
+
+    // only ever called from one thread
+    void publish(const OrientationEvent &event);
+
+    // a cursor that sees events published from now on
+    Cursor cursor() const;
+    bool read(Cursor &cursor, OrientationEvent *event) const;
+    int drain(Cursor &cursor, OrientationEvent *events, int max) const;
+
+private:
+    struct Slot {
+        std::atomic<quint64> sequence { 0 };   // 0 while being written, index + 1 once published
+        std::atomic<qint64> timestamp { 0 };
+        std::atomic<quint64> packed { 0 };
+    };
+
+    std::unique_ptr<Slot[]> m_slots;
+    quint64 m_mask;
+    std::atomic<quint64> m_head { 0 };
+};
+
+#endif // EVENTRING_H
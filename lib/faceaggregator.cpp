@@ -0,0 +1,322 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "faceaggregator.h"
+#include "sessionlog.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QTimer>
+
+#include <algorithm>
+
+namespace {
+    const qint64 msecsPerDay = 24 * 60 * 60 * 1000;
+
+    // bytes save() writes per device before its days, and per day
+    const qint64 savedDeviceSize = 8 + 1 + 8 + 4;
+    const qint64 savedDaySize = 8 + FaceAggregator::FaceCount * 8;
+
+    const QDate epochDay(1970, 1, 1);
+}
+
+FaceAggregator::FaceAggregator(QObject *parent)
+    : QAbstractListModel(parent)
+{
+    m_today = dayOf(QDateTime::currentMSecsSinceEpoch());
+
+    // today's totals start over at midnight, whether or not the die is flipped
+    m_midnightTimer = new QTimer(this);
+    m_midnightTimer->setSingleShot(true);
+    m_midnightTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_midnightTimer, &QTimer::timeout, this, [this]() {
+        setToday(dayOf(QDateTime::currentMSecsSinceEpoch()));
+        scheduleMidnight();
+    });
+    scheduleMidnight();
+}
+
+int FaceAggregator::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+        return 0;
+    return m_devices.size() * FaceCount;
+}
+
+QVariant FaceAggregator::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= rowCount())
+        return QVariant();
+
+    const Device &device = m_devices.at(index.row() / FaceCount);
+    const int face = index.row() % FaceCount;
+    switch (role) {
+    case DeviceIdRole:
+        return device.id;
+    case FaceRole:
+        return face;
+    case Qt::DisplayRole:
+    case TodayRole:
+        return dayTotal(device, face, m_today);
+    case TotalRole:
+        return device.prefix.isEmpty() ? 0 : device.prefix.last()[face];
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> FaceAggregator::roleNames() const
+{
+    return {
+        { DeviceIdRole, "deviceId" },
+        { FaceRole, "face" },
+        { TodayRole, "today" },
+        { TotalRole, "total" }
+    };
+}
+
+void FaceAggregator::addEvent(const OrientationEvent &event)
+{
+    Device *d = device(event.deviceId);
+    if (d->since != 0 && event.timestamp < d->since)
+        return;
+
+    const int previousFace = d->face;
+    if (d->since != 0)
+        accumulate(*d, d->since, event.timestamp);
+    d->face = qMin<quint8>(event.face, FaceCount - 1);
+    d->since = event.timestamp;
+    m_lastEvent = event;
+
+    if (!m_emitChanges)
+        return;
+
+    setToday(dayOf(event.timestamp));
+
+    const QModelIndex idx = index(d->row + previousFace);
+    emit dataChanged(idx, idx, { Qt::DisplayRole, TodayRole, TotalRole });
+}
+
+void FaceAggregator::load(const SessionLogReader &reader, qint64 first)
+{
+    beginResetModel();
+    m_emitChanges = false;
+    for (qint64 i = qMax<qint64>(0, first); i < reader.count(); ++i)
+        addEvent(reader.at(i));
+    m_emitChanges = true;
+    m_today = qMax(m_today, dayOf(QDateTime::currentMSecsSinceEpoch()));
+    scheduleMidnight();
+    endResetModel();
+}
+
+void FaceAggregator::clear()
+{
+    beginResetModel();
+    m_devices.clear();
+    m_deviceIndex.clear();
+    m_lastEvent = OrientationEvent();
+    endResetModel();
+}
+
+void FaceAggregator::save(QDataStream &out) const
+{
+    out << m_lastEvent.timestamp << quint64(m_lastEvent.deviceId) << m_lastEvent.face;
+    out << qint32(m_devices.size());
+    for (const Device &device : m_devices) {
+        out << quint64(device.id) << device.face << device.since << qint32(device.days.size());
+        for (int i = 0; i < device.days.size(); ++i) {
+            out << device.days.at(i);
+            for (qint64 total : device.prefix.at(i))
+                out << total;
+        }
+    }
+}
+
+bool FaceAggregator::restore(QDataStream &in)
+{
+    OrientationEvent lastEvent;
+    quint64 lastDeviceId = 0;
+    qint32 deviceCount = 0;
+    in >> lastEvent.timestamp >> lastDeviceId >> lastEvent.face >> deviceCount;
+    lastEvent.deviceId = lastDeviceId;
+    if (in.status() != QDataStream::Ok || !in.device())
+        return false;
+
+    // counts from a corrupt file must not turn into huge allocations, none
+    // can be larger than what is left to read
+    if (deviceCount < 0 || deviceCount > in.device()->bytesAvailable() / savedDeviceSize)
+        return false;
+
+    QVector<Device> devices;
+    for (qint32 d = 0; d < deviceCount && in.status() == QDataStream::Ok; ++d) {
+        Device device;
+        quint64 id = 0;
+        qint32 dayCount = 0;
+        in >> id >> device.face >> device.since >> dayCount;
+        if (in.status() != QDataStream::Ok || device.face >= FaceCount
+                || dayCount < 0 || dayCount > in.device()->bytesAvailable() / savedDaySize)
+            return false;
+        device.id = id;
+        device.row = d * FaceCount;
+        device.days.resize(dayCount);
+        device.prefix.resize(dayCount);
+        for (qint32 i = 0; i < dayCount; ++i) {
+            in >> device.days[i];
+            for (qint64 &total : device.prefix[i])
+                in >> total;
+            if (in.status() != QDataStream::Ok)
+                return false;
+        }
+        devices.append(device);
+    }
+    if (in.status() != QDataStream::Ok)
+        return false;
+
+    beginResetModel();
+    m_devices = devices;
+    m_deviceIndex.clear();
+    for (int i = 0; i < m_devices.size(); ++i)
+        m_deviceIndex.insert(m_devices.at(i).id, i);
+    m_lastEvent = lastEvent;
+    m_today = qMax(m_today, dayOf(QDateTime::currentMSecsSinceEpoch()));
+    scheduleMidnight();
+    endResetModel();
+    return true;
+}
+
+OrientationEvent FaceAggregator::lastEvent() const
+{
+    return m_lastEvent;
+}
+
+void FaceAggregator::setToday(qint64 day)
+{
+    if (day <= m_today)
+        return;
+
+    m_today = day;
+    emit todayChanged(m_today);
+    if (rowCount() > 0)
+        emit dataChanged(index(0), index(rowCount() - 1), { Qt::DisplayRole, TodayRole });
+    scheduleMidnight();
+}
+
+void FaceAggregator::scheduleMidnight()
+{
+    // a timer that fires a little early just finds the same day and tries again
+    const QDateTime midnight(QDate::currentDate().addDays(1), QTime(0, 0));
+    const qint64 remaining = QDateTime::currentDateTime().msecsTo(midnight);
+    m_midnightTimer->start(int(qBound<qint64>(1000, remaining, msecsPerDay)));
+}
+
+qint64 FaceAggregator::dayOf(qint64 timestamp) const
+{
+    // nearly every event falls on the same day as the one before
+    if (timestamp >= m_cachedDayStart && timestamp < m_cachedDayEnd)
+        return m_cachedDay;
+
+    // local calendar days, 23 or 25 hours long across a dst change
+    const qint64 day = epochDay.daysTo(QDateTime::fromMSecsSinceEpoch(timestamp).date());
+    m_cachedDay = day;
+    m_cachedDayStart = dayStart(day);
+    m_cachedDayEnd = dayStart(day + 1);
+    return day;
+}
+
+qint64 FaceAggregator::dayStart(qint64 day) const
+{
+    return QDateTime(epochDay.addDays(day), QTime(0, 0)).toMSecsSinceEpoch();
+}
+
+qint64 FaceAggregator::today() const
+{
+    return m_today;
+}
+
+qint64 FaceAggregator::duration(quint64 deviceId, int face, qint64 fromDay, qint64 toDay) const
+{
+    const auto it = m_deviceIndex.constFind(deviceId);
+    if (it == m_deviceIndex.constEnd() || face < 0 || face >= FaceCount || fromDay > toDay)
+        return 0;
+
+    const Device &device = m_devices.at(*it);
+    const int first = int(std::lower_bound(device.days.cbegin(), device.days.cend(), fromDay) - device.days.cbegin());
+    const int last = int(std::upper_bound(device.days.cbegin(), device.days.cend(), toDay) - device.days.cbegin()) - 1;
+    if (last < first)
+        return 0;
+    return device.prefix.at(last)[face] - (first > 0 ? device.prefix.at(first - 1)[face] : 0);
+}
+
+void FaceAggregator::accumulate(Device &device, qint64 from, qint64 to)
+{
+    // split intervals spanning midnight
+    while (from < to) {
+        const qint64 day = dayOf(from);
+        const qint64 dayEnd = dayStart(day + 1);
+        const qint64 end = qMin(to, dayEnd);
+        addTime(device, day, end - from);
+        from = end;
+    }
+}
+
+void FaceAggregator::addTime(Device &device, qint64 day, qint64 msecs)
+{
+    if (device.days.isEmpty() || device.days.last() < day) {
+        device.days.append(day);
+        device.prefix.append(device.prefix.isEmpty() ? Totals() : device.prefix.last());
+    } else if (device.days.last() > day) {
+        return;
+    }
+
+    device.prefix.last()[device.face] += msecs;
+}
+
+qint64 FaceAggregator::dayTotal(const Device &device, int face, qint64 day) const
+{
+    return duration(device.id, face, day, day);
+}
+
+FaceAggregator::Device *FaceAggregator::device(quint64 deviceId)
+{
+    const auto it = m_deviceIndex.constFind(deviceId);
+    if (it != m_deviceIndex.constEnd())
+        return &m_devices[*it];
+
+    const int row = m_devices.size() * FaceCount;
+    if (m_emitChanges)
+        beginInsertRows(QModelIndex(), row, row + FaceCount - 1);
+    Device device;
+    device.id = deviceId;
+    device.row = row;
+    m_deviceIndex.insert(deviceId, m_devices.size());
+    m_devices.append(device);
+    if (m_emitChanges)
+        endInsertRows();
+    return &m_devices.last();
+}
@@ -0,0 +1,123 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef FACEAGGREGATOR_H
+#define FACEAGGREGATOR_H
+
+#include <QAbstractListModel>
+#include <QHash>
+#include <QVector>
+
+#include <array>
+
+#include "orientationevent.h"
+
+class QDataStream;
+class QTimer;
+class SessionLogReader;
+
+// Running per device, per day, per face totals. Events have to arrive in time
+// order; each one closes the interval opened by the previous event of the same
+// device, the interval still in progress is not counted. Range queries are
+// answered from per day prefix sums.
+class FaceAggregator : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(qint64 today READ today NOTIFY todayChanged)
+public:
+    enum { FaceCount = 9 };
+
+    enum Roles {
+        DeviceIdRole = Qt::UserRole + 1,
+        FaceRole,
+        TodayRole,
+        TotalRole
+    };
+    Q_ENUM(Roles)
+
+    explicit FaceAggregator(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    void addEvent(const OrientationEvent &event);
+    // replays the records from index first on
+    void load(const SessionLogReader &reader, qint64 first = 0);
+    void clear();
+
+    // the whole state, to pick up from without replaying the events
+    void save(QDataStream &out) const;
+    bool restore(QDataStream &in);
+
+    // the latest event that was counted, its face is still in progress
+    OrientationEvent lastEvent() const;
+
+    qint64 today() const;
+    Q_INVOKABLE qint64 dayOf(qint64 timestamp) const;
+
+    // msecs spent on face by device in the days [fromDay, toDay]
+    Q_INVOKABLE qint64 duration(quint64 deviceId, int face, qint64 fromDay, qint64 toDay) const;
+
+signals:
+    void todayChanged(qint64 today);
+
+private:
+    typedef std::array<qint64, FaceCount> Totals;
+
+    struct Device {
+        quint64 id = 0;
+        int row = 0;
+        quint8 face = 0;
+        qint64 since = 0;
+        QVector<qint64> days;
+        QVector<Totals> prefix;   // prefix[i] sums days[0..i]
+    };
+
+    void setToday(qint64 day);
+    void scheduleMidnight();
+    qint64 dayStart(qint64 day) const;
+    void accumulate(Device &device, qint64 from, qint64 to);
+    void addTime(Device &device, qint64 day, qint64 msecs);
+    qint64 dayTotal(const Device &device, int face, qint64 day) const;
+    Device *device(quint64 deviceId);
+
+    QHash<quint64, int> m_deviceIndex;
+    QVector<Device> m_devices;
+    OrientationEvent m_lastEvent;
+    // the day dayOf() last looked up, and its bounds
+    mutable qint64 m_cachedDay = 0;
+    mutable qint64 m_cachedDayStart = 0;
+    mutable qint64 m_cachedDayEnd = 0;
+    qint64 m_today = 0;
+    QTimer *m_midnightTimer = nullptr;
+    bool m_emitChanges = true;
+};
+
+#endif // FACEAGGREGATOR_H
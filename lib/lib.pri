@@ -0,0 +1,15 @@
+# Links the static timeular library into a sibling project
+QT += bluetooth network
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+# the library's build directory, wherever the including project sits in the tree
+TIMEULAR_LIB_DIR = $$shadowed($$PWD)
+win32:CONFIG(release, debug|release): TIMEULAR_LIB_DIR = $$TIMEULAR_LIB_DIR/release
+else:win32:CONFIG(debug, debug|release): TIMEULAR_LIB_DIR = $$TIMEULAR_LIB_DIR/debug
+
+LIBS += -L$$TIMEULAR_LIB_DIR -ltimeular
+
+win32-msvc*: PRE_TARGETDEPS += $$TIMEULAR_LIB_DIR/timeular.lib
+else: PRE_TARGETDEPS += $$TIMEULAR_LIB_DIR/libtimeular.a
@@ -0,0 +1,73 @@
+TEMPLATE = lib
+TARGET = timeular
+CONFIG += staticlib
+QT = core bluetooth network
+
+include(../common.pri)
+
+SOURCES += \
+    adapterbalancer.cpp \
+    bletransport.cpp \
+    devicecache.cpp \
+    deviceprofile.cpp \
+    eventexporter.cpp \
+    eventring.cpp \
+    faceaggregator.cpp \
+    linkprofile.cpp \
+    linksupervisor.cpp \
+    metrics.cpp \
+    metricsserver.cpp \
+    orientationfilter.cpp \
+    presencetracker.cpp \
+    processinfo.cpp \
+    scanscheduler.cpp \
+    sessionlog.cpp \
+    sessionsnapshot.cpp \
+    simulatedtransport.cpp \
+    simulator.cpp \
+    startuptrace.cpp \
+    telemetryscheduler.cpp \
+    threadedtimeularmanager.cpp \
+    timeularbroker.cpp \
+    timeularbrokerclient.cpp \
+    timeulardevice.cpp \
+    timeularmanager.cpp \
+    timeularpool.cpp \
+    timeularstats.cpp \
+    zeidecoder.cpp
+
+HEADERS += \
+    adapterbalancer.h \
+    bletransport.h \
+    brokerprotocol.h \
+    devicecache.h \
+    deviceprofile.h \
+    eventexporter.h \
+    eventring.h \
+    faceaggregator.h \
+    linkprofile.h \
+    linksupervisor.h \
+    metrics.h \
+    metricsserver.h \
+    orientationevent.h \
+    orientationfilter.h \
+    presencetracker.h \
+    processinfo.h \
+    scanscheduler.h \
+    sessionlog.h \
+    sessionsnapshot.h \
+    simulatedtransport.h \
+    simulator.h \
+    startuptrace.h \
+    telemetryscheduler.h \
+    threadedtimeularmanager.h \
+    timeularbroker.h \
+    timeularbrokerclient.h \
+    timeulardevice.h \
+    timeularmanager.h \
+    timeularpool.h \
+    timeularstats.h \
+    timeulartransport.h \
+    zeidecoder.h
+
+OTHER_FILES += lib.pri
@@ -0,0 +1,155 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "linkprofile.h"
+
+#include <QTimer>
+
+LinkProfile::LinkProfile(QObject *parent)
+    : QObject(parent)
+{
+    m_clock.start();
+    m_recent.fill(0, m_interactiveThreshold);
+    m_idleTimer = new QTimer(this);
+    m_idleTimer->setSingleShot(true);
+    connect(m_idleTimer, &QTimer::timeout, this, &LinkProfile::update);
+}
+
+QLowEnergyConnectionParameters LinkProfile::parameters(Profile profile)
+{
+    QLowEnergyConnectionParameters params;
+    switch (profile) {
+    case Interactive:
+        params.setIntervalRange(15, 30);
+        params.setLatency(0);
+        params.setSupervisionTimeout(2000);
+        break;
+    case Background:
+        // max interval * (latency + 1) stays below 2s, which keeps macOS and iOS happy
+        params.setIntervalRange(100, 200);
+        params.setLatency(4);
+        params.setSupervisionTimeout(6000);
+        break;
+    }
+    return params;
+}
+
+QLowEnergyConnectionParameters LinkProfile::parameters() const
+{
+    return parameters(m_profile);
+}
+
+LinkProfile::Profile LinkProfile::profile() const
+{
+    return m_profile;
+}
+
+void LinkProfile::setProfile(Profile profile)
+{
+    if (profile != m_profile) {
+        m_profile = profile;
+        emit profileChanged(m_profile);
+    }
+}
+
+bool LinkProfile::isAutomatic() const
+{
+    return m_automatic;
+}
+
+void LinkProfile::setAutomatic(bool automatic)
+{
+    if (automatic != m_automatic) {
+        m_automatic = automatic;
+        emit automaticChanged(m_automatic);
+        update();
+    }
+}
+
+int LinkProfile::activityWindow() const
+{
+    return m_activityWindow;
+}
+
+void LinkProfile::setActivityWindow(int msecs)
+{
+    m_activityWindow = qMax(1000, msecs);
+}
+
+int LinkProfile::interactiveThreshold() const
+{
+    return m_interactiveThreshold;
+}
+
+void LinkProfile::setInteractiveThreshold(int events)
+{
+    m_interactiveThreshold = qMax(1, events);
+    m_recent.fill(0, m_interactiveThreshold);
+    m_next = 0;
+    m_filled = 0;
+}
+
+void LinkProfile::addEvent()
+{
+    // called for every face change, only touches fixed storage
+    const qint64 now = m_clock.elapsed();
+    m_recent[m_next] = now;
+    m_next = (m_next + 1) % m_recent.size();
+    m_filled = qMin(m_filled + 1, m_recent.size());
+    if (m_filled == m_recent.size() && now - m_recent.at(m_next) < m_activityWindow)
+        m_busyUntil = now + m_activityWindow;
+    update();
+}
+
+void LinkProfile::reset()
+{
+    // a fresh link starts out interactive, someone just picked up the die
+    m_next = 0;
+    m_filled = 0;
+    m_busyUntil = m_clock.elapsed() + m_activityWindow;
+    m_idleTimer->stop();
+    update();
+}
+
+void LinkProfile::update()
+{
+    if (!m_automatic)
+        return;
+
+    const qint64 now = m_clock.elapsed();
+    if (now < m_busyUntil) {
+        setProfile(Interactive);
+        // re-armed for the rest when it fires, restarting it per event would cost more than the event
+        if (!m_idleTimer->isActive())
+            m_idleTimer->start(int(m_busyUntil - now));
+    } else {
+        // nothing happened for a whole window since going interactive
+        setProfile(Background);
+    }
+}
@@ -0,0 +1,93 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef LINKPROFILE_H
+#define LINKPROFILE_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QLowEnergyConnectionParameters>
+#include <QVector>
+
+class QTimer;
+
+// Picks the connection parameters for a link from its recent event rate.
+// A die that is being flipped gets a short interval, an idle one a long
+// interval with slave latency so the peripheral can skip connection events.
+class LinkProfile : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(Profile profile READ profile WRITE setProfile NOTIFY profileChanged)
+    Q_PROPERTY(bool automatic READ isAutomatic WRITE setAutomatic NOTIFY automaticChanged)
+public:
+    enum Profile {
+        Background,
+        Interactive
+    };
+    Q_ENUM(Profile)
+
+    explicit LinkProfile(QObject *parent = nullptr);
+
+    static QLowEnergyConnectionParameters parameters(Profile profile);
+    QLowEnergyConnectionParameters parameters() const;
+
+    Profile profile() const;
+    void setProfile(Profile profile);
+    bool isAutomatic() const;
+    void setAutomatic(bool automatic);
+
+    int activityWindow() const;
+    void setActivityWindow(int msecs);
+    int interactiveThreshold() const;
+    void setInteractiveThreshold(int events);
+
+    void addEvent();
+    void reset();
+
+signals:
+    void profileChanged(Profile profile);
+    void automaticChanged(bool automatic);
+
+private:
+    void update();
+
+    Profile m_profile = Interactive;
+    bool m_automatic = true;
+    int m_activityWindow = 60000;
+    int m_interactiveThreshold = 2;
+    QElapsedTimer m_clock;
+    // the last m_interactiveThreshold event times, m_next is the oldest once full
+    QVector<qint64> m_recent;
+    int m_next = 0;
+    int m_filled = 0;
+    qint64 m_busyUntil = 0;
+    QTimer *m_idleTimer = nullptr;
+};
+
+#endif // LINKPROFILE_H
@@ -0,0 +1,160 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "linksupervisor.h"
+#include "metrics.h"
+#include "timeulardevice.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QTimer>
+
+LinkSupervisor::LinkSupervisor(TimeularDevice *device)
+    : QObject(device)
+    , m_device(device)
+{
+    m_retryTimer = new QTimer(this);
+    m_retryTimer->setSingleShot(true);
+    connect(m_retryTimer, &QTimer::timeout, this, &LinkSupervisor::retry);
+
+    // RF dropouts usually clear up within a few seconds, past that the die is gone
+    m_deadline = new QTimer(this);
+    m_deadline->setSingleShot(true);
+    m_deadline->setInterval(10000);
+    connect(m_deadline, &QTimer::timeout, this, &LinkSupervisor::giveUp);
+
+    connect(m_device, &TimeularDevice::linkLost,
+            this, &LinkSupervisor::linkLost);
+    connect(m_device, &TimeularDevice::statusChanged,
+            this, &LinkSupervisor::statusChanged);
+}
+
+bool LinkSupervisor::isEnabled() const
+{
+    return m_enabled;
+}
+
+void LinkSupervisor::setEnabled(bool enabled)
+{
+    m_enabled = enabled;
+}
+
+int LinkSupervisor::reconnectWindow() const
+{
+    return m_deadline->interval();
+}
+
+void LinkSupervisor::setReconnectWindow(int msecs)
+{
+    m_deadline->setInterval(qMax(0, msecs));
+}
+
+int LinkSupervisor::retryInterval() const
+{
+    return m_retryInterval;
+}
+
+void LinkSupervisor::setRetryInterval(int msecs)
+{
+    m_retryInterval = qMax(0, msecs);
+}
+
+bool LinkSupervisor::isRecovering() const
+{
+    return m_recovering;
+}
+
+qint64 LinkSupervisor::lastGap() const
+{
+    return m_lastGap;
+}
+
+int LinkSupervisor::gapCount() const
+{
+    return m_gapCount;
+}
+
+void LinkSupervisor::linkLost()
+{
+    if (!m_enabled || m_recovering)
+        return;
+
+    qDebug() << "Link lost, reconnecting" << m_device->key();
+    m_recovering = true;
+    m_lostAt = QDateTime::currentMSecsSinceEpoch();
+    m_gapClock.start();
+    m_deadline->start();
+    // the device only reports Disconnected after linkLost()
+    m_retryTimer->start(0);
+}
+
+void LinkSupervisor::statusChanged(int status)
+{
+    if (!m_recovering)
+        return;
+
+    switch (status) {
+    case TimeularDevice::Connected:
+        m_recovering = false;
+        m_retryTimer->stop();
+        m_deadline->stop();
+        m_lastGap = m_gapClock.elapsed();
+        ++m_gapCount;
+        // the transport reads the current face as part of subscribing
+        qDebug() << "Link restored after" << m_lastGap << "ms";
+        Metrics::add(Metrics::LinksRestored);
+        emit linkRestored(m_lostAt, m_lastGap);
+        break;
+    case TimeularDevice::Disconnected:
+        if (!m_retryTimer->isActive())
+            m_retryTimer->start(m_retryInterval);
+        break;
+    default:
+        break;
+    }
+}
+
+void LinkSupervisor::retry()
+{
+    if (m_recovering && m_device->status() == TimeularDevice::Disconnected)
+        m_device->connectToDevice();
+}
+
+void LinkSupervisor::giveUp()
+{
+    if (!m_recovering)
+        return;
+
+    qDebug() << "Link not restored within" << m_deadline->interval() << "ms";
+    m_recovering = false;
+    m_retryTimer->stop();
+    m_device->disconnectFromDevice();
+    Metrics::add(Metrics::RecoveriesFailed);
+    emit recoveryFailed();
+}
@@ -0,0 +1,84 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef LINKSUPERVISOR_H
+#define LINKSUPERVISOR_H
+
+#include <QObject>
+#include <QElapsedTimer>
+
+class QTimer;
+class TimeularDevice;
+
+// Reconnects a device straight away when its link drops unexpectedly,
+// reusing the device's transport instead of waiting for discovery. The time
+// between losing and restoring the link is reported so consumers can
+// account for it.
+class LinkSupervisor : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LinkSupervisor(TimeularDevice *device);
+
+    bool isEnabled() const;
+    void setEnabled(bool enabled);
+    int reconnectWindow() const;
+    void setReconnectWindow(int msecs);
+    int retryInterval() const;
+    void setRetryInterval(int msecs);
+
+    bool isRecovering() const;
+    // msecs, of the last restored link
+    qint64 lastGap() const;
+    int gapCount() const;
+
+signals:
+    // lostAt is in msecs since epoch
+    void linkRestored(qint64 lostAt, qint64 gap);
+    void recoveryFailed();
+
+private:
+    void linkLost();
+    void statusChanged(int status);
+    void retry();
+    void giveUp();
+
+    TimeularDevice *m_device;
+    QTimer *m_retryTimer = nullptr;
+    QTimer *m_deadline = nullptr;
+    QElapsedTimer m_gapClock;
+    bool m_enabled = true;
+    bool m_recovering = false;
+    int m_retryInterval = 500;
+    qint64 m_lostAt = 0;
+    qint64 m_lastGap = 0;
+    int m_gapCount = 0;
+};
+
+#endif // LINKSUPERVISOR_H
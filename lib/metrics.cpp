@@ -0,0 +1,145 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "metrics.h"
+
+#include <QMetaEnum>
+
+namespace {
+    struct Series {
+        const char *name;
+        const char *help;
+    };
+
+    const Series counterSeries[Metrics::CounterCount] = {
+        { "timeular_connect_attempts_total", "Connection attempts started." },
+        { "timeular_connects_total", "Connections that got as far as the orientation subscription." },
+        { "timeular_connect_failures_total", "Connection attempts that ended before subscribing." },
+        { "timeular_links_lost_total", "Established links that dropped." },
+        { "timeular_links_restored_total", "Dropped links reconnected by the supervisor." },
+        { "timeular_recoveries_failed_total", "Dropped links that had to fall back to discovery." },
+        { "timeular_notifications_total", "Orientation notifications received." },
+        { "timeular_orientation_changes_total", "Face changes delivered." },
+        { "timeular_battery_reads_total", "Battery levels read." },
+        { "timeular_controller_errors_total", "Errors reported by the Bluetooth controller." },
+        { "timeular_service_errors_total", "Errors reported by GATT services." },
+        { "timeular_export_dropped_events_total", "Events the exporter lost because it fell a full ring behind." }
+    };
+
+    struct Histogram {
+        std::atomic<quint64> buckets[LatencyHistogram::BucketCount];
+        std::atomic<quint64> count;
+        std::atomic<quint64> sum;
+    };
+
+    Histogram histograms[TimeularStats::PhaseCount];
+
+    void appendHeader(QByteArray &out, const char *name, const char *help, const char *type)
+    {
+        out += "# HELP ";
+        out += name;
+        out += ' ';
+        out += help;
+        out += "\n# TYPE ";
+        out += name;
+        out += ' ';
+        out += type;
+        out += '\n';
+    }
+}
+
+std::atomic<quint64> Metrics::s_counters[Metrics::CounterCount];
+std::atomic<bool> Metrics::s_enabled(false);
+
+quint64 Metrics::value(Counter counter)
+{
+    return s_counters[counter].load(std::memory_order_relaxed);
+}
+
+void Metrics::setEnabled(bool enabled)
+{
+    s_enabled.store(enabled);
+}
+
+void Metrics::observe(TimeularStats::Phase phase, qint64 usecs)
+{
+    if (!isEnabled())
+        return;
+
+    usecs = qMax<qint64>(0, usecs);
+    Histogram &h = histograms[phase];
+    h.buckets[LatencyHistogram::bucketFor(usecs)].fetch_add(1, std::memory_order_relaxed);
+    h.sum.fetch_add(quint64(usecs), std::memory_order_relaxed);
+    h.count.fetch_add(1, std::memory_order_relaxed);
+}
+
+QByteArray Metrics::exposition(const QByteArray &extra)
+{
+    QByteArray out;
+    out.reserve(16 * 1024);
+
+    for (int i = 0; i < CounterCount; ++i) {
+        appendHeader(out, counterSeries[i].name, counterSeries[i].help, "counter");
+        out += counterSeries[i].name;
+        out += ' ';
+        out += QByteArray::number(s_counters[i].load(std::memory_order_relaxed));
+        out += '\n';
+    }
+
+    // bucket i holds durations below 2^(i + 1) usecs, see LatencyHistogram
+    const char *name = "timeular_phase_duration_seconds";
+    appendHeader(out, name, "Time taken by each step of connecting and delivering a face.", "histogram");
+    const QMetaEnum phases = QMetaEnum::fromType<TimeularStats::Phase>();
+    for (int p = 0; p < TimeularStats::PhaseCount; ++p) {
+        const Histogram &h = histograms[p];
+        const QByteArray label = QByteArray("phase=\"") + phases.valueToKey(p) + '"';
+        quint64 cumulative = 0;
+        for (int i = 0; i < LatencyHistogram::BucketCount; ++i) {
+            cumulative += h.buckets[i].load(std::memory_order_relaxed);
+            // the last bucket has no upper bound, it is only counted in +Inf
+            if (i == LatencyHistogram::BucketCount - 1)
+                break;
+            out += name;
+            out += "_bucket{" + label + ",le=\"";
+            out += QByteArray::number(double(qint64(1) << (i + 1)) / 1e6, 'g', 10);
+            out += "\"} " + QByteArray::number(cumulative) + '\n';
+        }
+        // a concurrent observe() may have reached the buckets but not the count yet
+        const quint64 count = qMax(cumulative, h.count.load(std::memory_order_relaxed));
+        out += name;
+        out += "_bucket{" + label + ",le=\"+Inf\"} " + QByteArray::number(count) + '\n';
+        out += name;
+        out += "_sum{" + label + "} " + QByteArray::number(double(h.sum.load(std::memory_order_relaxed)) / 1e6, 'f', 6) + '\n';
+        out += name;
+        out += "_count{" + label + "} " + QByteArray::number(count) + '\n';
+    }
+
+    out += extra;
+    return out;
+}
@@ -0,0 +1,82 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QtGlobal>
+#include <QByteArray>
+
+#include <atomic>
+
+#include "timeularstats.h"
+
+// Process wide counters and latency histograms in the Prometheus text
+// format. Every series is allocated up front and updated with relaxed
+// atomics, so counting costs the same whether anybody scrapes or not and
+// works from any thread. Histograms need timestamps and are only filled
+// while enabled.
+class Metrics
+{
+public:
+    enum Counter {
+        ConnectAttempts,
+        Connects,               // subscribed to the orientation
+        ConnectFailures,        // attempts that ended before subscribing
+        LinksLost,
+        LinksRestored,          // reconnected by the link supervisor
+        RecoveriesFailed,
+        Notifications,
+        OrientationChanges,
+        BatteryReads,
+        ControllerErrors,
+        ServiceErrors,
+        ExportDrops,            // events the exporter lost to a full ring
+        CounterCount
+    };
+
+    static void add(Counter counter, quint64 value = 1)
+    {
+        s_counters[counter].fetch_add(value, std::memory_order_relaxed);
+    }
+    static quint64 value(Counter counter);
+
+    static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+    static void setEnabled(bool enabled);
+    static void observe(TimeularStats::Phase phase, qint64 usecs);
+
+    // text exposition format 0.0.4, extra is appended as is
+    static QByteArray exposition(const QByteArray &extra = QByteArray());
+
+private:
+    static std::atomic<quint64> s_counters[CounterCount];
+    static std::atomic<bool> s_enabled;
+};
+
+#endif // METRICS_H
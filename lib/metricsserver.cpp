@@ -0,0 +1,181 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "metricsserver.h"
+#include "metrics.h"
+#include "processinfo.h"
+#include "timeularmanager.h"
+
+#include <QDebug>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+
+namespace {
+    // scrapers send a few hundred bytes, anything bigger isn't one
+    const int maxRequestSize = 8 * 1024;
+    // and send it at once, a connection still without a request is dropped
+    const int requestTimeout = 5000;
+
+    void appendSeries(QByteArray &out, const char *name, const char *type, const char *help, qint64 value)
+    {
+        out += "# HELP ";
+        out += name;
+        out += ' ';
+        out += help;
+        out += "\n# TYPE ";
+        out += name;
+        out += ' ';
+        out += type;
+        out += '\n';
+        out += name;
+        out += ' ';
+        out += QByteArray::number(value);
+        out += '\n';
+    }
+}
+
+MetricsServer::MetricsServer(QObject *parent)
+    : QObject(parent)
+{
+    m_server = new QTcpServer(this);
+    connect(m_server, &QTcpServer::newConnection,
+            this, &MetricsServer::newConnection);
+}
+
+MetricsServer::~MetricsServer()
+{
+    close();
+}
+
+bool MetricsServer::listen(const QHostAddress &address, quint16 port)
+{
+    if (!m_server->listen(address, port)) {
+        qWarning() << "Can't serve metrics on port" << port << m_server->errorString();
+        return false;
+    }
+    Metrics::setEnabled(true);
+    return true;
+}
+
+void MetricsServer::close()
+{
+    if (!m_server->isListening())
+        return;
+
+    m_server->close();
+    Metrics::setEnabled(false);
+}
+
+quint16 MetricsServer::port() const
+{
+    return m_server->serverPort();
+}
+
+void MetricsServer::attach(TimeularManager *manager)
+{
+    m_manager = manager;
+}
+
+void MetricsServer::newConnection()
+{
+    while (QTcpSocket *socket = m_server->nextPendingConnection()) {
+        // an entry until the response is on its way
+        m_requests.insert(socket, QByteArray());
+        QTimer::singleShot(requestTimeout, socket, [this, socket]() {
+            if (m_requests.contains(socket))
+                socket->abort();
+        });
+        connect(socket, &QTcpSocket::readyRead,
+                this, [this, socket]() { readRequest(socket); });
+        connect(socket, &QTcpSocket::disconnected,
+                this, [this, socket]() {
+                    m_requests.remove(socket);
+                    socket->deleteLater();
+                });
+    }
+}
+
+void MetricsServer::readRequest(QTcpSocket *socket)
+{
+    if (!m_requests.contains(socket))
+        return;
+
+    QByteArray &request = m_requests[socket];
+    request += socket->readAll();
+    if (request.size() > maxRequestSize) {
+        socket->abort();
+        return;
+    }
+    if (!request.contains("\r\n\r\n"))
+        return;
+
+    // one request per connection, scrapes are seconds apart
+    QByteArray status;
+    QByteArray body;
+    const QList<QByteArray> requestLine = request.left(request.indexOf("\r\n")).split(' ');
+    const QByteArray path = requestLine.value(1);
+    if (requestLine.value(0) != "GET") {
+        status = "405 Method Not Allowed";
+    } else if (path == "/metrics" || path.startsWith("/metrics?")) {
+        status = "200 OK";
+        body = Metrics::exposition(managerSeries());
+    } else {
+        status = "404 Not Found";
+    }
+    m_requests.remove(socket);
+
+    QByteArray response = "HTTP/1.1 " + status + "\r\n";
+    if (!body.isEmpty())
+        response += "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n";
+    response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+                "Connection: close\r\n\r\n";
+    socket->write(response + body);
+    socket->disconnectFromHost();
+}
+
+QByteArray MetricsServer::managerSeries() const
+{
+    QByteArray out;
+    appendSeries(out, "timeular_resident_memory_bytes", "gauge", "Resident set size, -1 where unavailable.",
+                 ProcessInfo::residentMemory());
+    if (!m_manager)
+        return out;
+
+    appendSeries(out, "timeular_connected", "gauge", "1 while the die is connected.",
+                 m_manager->status() == TimeularManager::Connected ? 1 : 0);
+    appendSeries(out, "timeular_battery_percent", "gauge", "Battery level of the die, -1 while unknown.",
+                 m_manager->batteryLevel());
+    appendSeries(out, "timeular_rssi_dbm", "gauge", "Signal strength of the last advertisement, 0 while unknown.",
+                 m_manager->rssi());
+    // starts over with another die, which Prometheus treats like a restart
+    appendSeries(out, "timeular_link_gaps_total", "counter", "Dropped links restored on the current die.",
+                 m_manager->linkGaps());
+    return out;
+}
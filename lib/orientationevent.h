@@ -27,23 +27,18 @@
   POSSIBILITY OF SUCH DAMAGE.
 */
 
-#include <QGuiApplication>
-#include <QQmlApplicationEngine>
+#ifndef ORIENTATIONEVENT_H
+#define ORIENTATIONEVENT_H
 
-#include <timeularmanager.h>
+#include <QtGlobal>
 
-int main(int argc, char *argv[])
+struct OrientationEvent
 {
-    QCoreApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
+    qint64 timestamp = 0;   // msecs since epoch
+    quint64 deviceId = 0;   // 48 bit device address
+    quint8 face = 0;
+};
 
-    QGuiApplication app(argc, argv);
+Q_DECLARE_TYPEINFO(OrientationEvent, Q_PRIMITIVE_TYPE);
 
-    qmlRegisterType<TimeularManager>("Timeular", 1, 0, "TimeularManager");
-
-    QQmlApplicationEngine engine;
-    engine.load(QUrl(QStringLiteral("qrc:/main.qml")));
-    if (engine.rootObjects().isEmpty())
-        return -1;
-
-    return app.exec();
-}
+#endif // ORIENTATIONEVENT_H
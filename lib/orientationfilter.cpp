@@ -0,0 +1,113 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "orientationfilter.h"
+
+#include <QTimer>
+
+OrientationFilter::OrientationFilter(QObject *parent)
+    : QObject(parent)
+{
+    m_settleTimer = new QTimer(this);
+    m_settleTimer->setSingleShot(true);
+    connect(m_settleTimer, &QTimer::timeout, this, &OrientationFilter::commit);
+}
+
+int OrientationFilter::settleTime() const
+{
+    return m_settleTime;
+}
+
+void OrientationFilter::setSettleTime(int msecs)
+{
+    m_settleTime = qMax(0, msecs);
+}
+
+int OrientationFilter::verticalSettleTime() const
+{
+    return m_verticalSettleTime;
+}
+
+void OrientationFilter::setVerticalSettleTime(int msecs)
+{
+    m_verticalSettleTime = qMax(0, msecs);
+}
+
+int OrientationFilter::stableOrientation() const
+{
+    return m_stable;
+}
+
+quint64 OrientationFilter::suppressedCount() const
+{
+    return m_suppressed;
+}
+
+void OrientationFilter::addSample(int orientation, qint64 timestamp)
+{
+    if (m_pending) {
+        if (orientation == m_candidate)
+            return;
+
+        // the previous candidate never settled
+        m_pending = false;
+        m_settleTimer->stop();
+        emit suppressedCountChanged(++m_suppressed);
+    }
+
+    if (orientation == m_stable)
+        return;
+
+    m_candidate = orientation;
+    m_candidateSince = timestamp;
+    m_pending = true;
+
+    const int settle = orientation == 0 ? m_verticalSettleTime : m_settleTime;
+    if (settle == 0)
+        commit();
+    else
+        m_settleTimer->start(settle);
+}
+
+void OrientationFilter::reset(int orientation)
+{
+    m_settleTimer->stop();
+    m_pending = false;
+    m_stable = orientation;
+}
+
+void OrientationFilter::commit()
+{
+    if (!m_pending)
+        return;
+
+    m_pending = false;
+    m_stable = m_candidate;
+    emit stableOrientationChanged(m_stable, m_candidateSince);
+}
@@ -0,0 +1,74 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef ORIENTATIONFILTER_H
+#define ORIENTATIONFILTER_H
+
+#include <QObject>
+
+class QTimer;
+
+// Only commits a face once it has been held for the settle time. Vertical,
+// which the die reports while being picked up, can get a longer settle time.
+class OrientationFilter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit OrientationFilter(QObject *parent = nullptr);
+
+    int settleTime() const;
+    void setSettleTime(int msecs);
+    int verticalSettleTime() const;
+    void setVerticalSettleTime(int msecs);
+
+    int stableOrientation() const;
+    quint64 suppressedCount() const;
+
+    void addSample(int orientation, qint64 timestamp);
+    void reset(int orientation);
+
+signals:
+    // timestamp is the time the face was first seen, not the commit time
+    void stableOrientationChanged(int orientation, qint64 timestamp);
+    void suppressedCountChanged(quint64 count);
+
+private:
+    void commit();
+
+    QTimer *m_settleTimer = nullptr;
+    int m_settleTime = 300;
+    int m_verticalSettleTime = 1000;
+    int m_stable = 0;
+    int m_candidate = 0;
+    qint64 m_candidateSince = 0;
+    bool m_pending = false;
+    quint64 m_suppressed = 0;
+};
+
+#endif // ORIENTATIONFILTER_H
@@ -0,0 +1,149 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "presencetracker.h"
+#include "timeulardevice.h"
+
+#include <QDateTime>
+#include <QTimer>
+
+PresenceTracker::PresenceTracker(QObject *parent)
+    : QObject(parent)
+{
+    m_clock.start();
+    m_started = QDateTime::currentMSecsSinceEpoch();
+
+    m_sweep = new QTimer(this);
+    m_sweep->setInterval(m_timeout / 4);
+    connect(m_sweep, &QTimer::timeout, this, &PresenceTracker::expire);
+}
+
+int PresenceTracker::presentCount() const
+{
+    return m_presentCount;
+}
+
+int PresenceTracker::timeout() const
+{
+    return m_timeout;
+}
+
+void PresenceTracker::setTimeout(int msecs)
+{
+    msecs = qMax(1000, msecs);
+    if (msecs != m_timeout) {
+        m_timeout = msecs;
+        m_sweep->setInterval(m_timeout / 4);
+        emit timeoutChanged(m_timeout);
+    }
+}
+
+bool PresenceTracker::isPresent(quint64 deviceId) const
+{
+    return m_entries.value(deviceId).present;
+}
+
+qint16 PresenceTracker::rssi(quint64 deviceId) const
+{
+    return m_entries.value(deviceId).rssi;
+}
+
+qint64 PresenceTracker::lastSeen(quint64 deviceId) const
+{
+    const auto it = m_entries.constFind(deviceId);
+    return it == m_entries.cend() ? 0 : toEpoch(it->lastSeen);
+}
+
+QVariantList PresenceTracker::devices() const
+{
+    QVariantList result;
+    for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it) {
+        QVariantMap entry;
+        entry.insert(QStringLiteral("device"), QString::number(it.key(), 16));
+        entry.insert(QStringLiteral("rssi"), it->rssi);
+        entry.insert(QStringLiteral("lastSeen"), toEpoch(it->lastSeen));
+        entry.insert(QStringLiteral("present"), it->present);
+        result.append(entry);
+    }
+    return result;
+}
+
+void PresenceTracker::sighted(const QBluetoothDeviceInfo &info)
+{
+    if (!TimeularDevice::isTimeularDevice(info))
+        return;
+
+    const quint64 id = TimeularDevice::deviceId(info);
+    Entry &entry = m_entries[id];
+    entry.lastSeen = m_clock.elapsed();
+    if (info.rssi() != 0)
+        entry.rssi = info.rssi();
+
+    if (!entry.present) {
+        entry.present = true;
+        ++m_presentCount;
+        if (!m_sweep->isActive())
+            m_sweep->start();
+        emit presenceChanged(id, true);
+        emit presentCountChanged(m_presentCount);
+    }
+    emit sightingUpdated(id);
+}
+
+void PresenceTracker::clear()
+{
+    m_entries.clear();
+    m_sweep->stop();
+    if (m_presentCount != 0) {
+        m_presentCount = 0;
+        emit presentCountChanged(m_presentCount);
+    }
+}
+
+void PresenceTracker::expire()
+{
+    const qint64 now = m_clock.elapsed();
+    const int before = m_presentCount;
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+        if (it->present && now - it->lastSeen >= m_timeout) {
+            it->present = false;
+            --m_presentCount;
+            emit presenceChanged(it.key(), false);
+        }
+    }
+    if (m_presentCount == 0)
+        m_sweep->stop();
+    if (m_presentCount != before)
+        emit presentCountChanged(m_presentCount);
+}
+
+qint64 PresenceTracker::toEpoch(qint64 elapsed) const
+{
+    return m_started + elapsed;
+}
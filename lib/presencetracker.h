@@ -0,0 +1,92 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef PRESENCETRACKER_H
+#define PRESENCETRACKER_H
+
+#include <QObject>
+#include <QBluetoothDeviceInfo>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QVariantList>
+
+class QTimer;
+
+// Tracks which dice are around from their advertisements alone, without
+// connecting to any of them. A die counts as present until nothing was
+// heard from it for the timeout.
+class PresenceTracker : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int presentCount READ presentCount NOTIFY presentCountChanged)
+    Q_PROPERTY(int timeout READ timeout WRITE setTimeout NOTIFY timeoutChanged)
+public:
+    explicit PresenceTracker(QObject *parent = nullptr);
+
+    int presentCount() const;
+    int timeout() const;
+    void setTimeout(int msecs);
+
+    bool isPresent(quint64 deviceId) const;
+    qint16 rssi(quint64 deviceId) const;
+    // msecs since epoch, 0 if never seen
+    qint64 lastSeen(quint64 deviceId) const;
+
+    // one map per die heard: device (hex), rssi, lastSeen, present
+    Q_INVOKABLE QVariantList devices() const;
+
+public slots:
+    void sighted(const QBluetoothDeviceInfo &info);
+    void clear();
+
+signals:
+    void presenceChanged(quint64 deviceId, bool present);
+    void sightingUpdated(quint64 deviceId);
+    void presentCountChanged(int count);
+    void timeoutChanged(int msecs);
+
+private:
+    struct Entry {
+        qint64 lastSeen = 0;    // on m_clock
+        qint16 rssi = 0;
+        bool present = false;
+    };
+
+    void expire();
+    qint64 toEpoch(qint64 elapsed) const;
+
+    QHash<quint64, Entry> m_entries;
+    QElapsedTimer m_clock;
+    qint64 m_started = 0;
+    QTimer *m_sweep = nullptr;
+    int m_timeout = 120000;
+    int m_presentCount = 0;
+};
+
+#endif // PRESENCETRACKER_H
@@ -0,0 +1,165 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "processinfo.h"
+
+#if defined(Q_OS_LINUX)
+#  include <QFile>
+#  include <unistd.h>
+#endif
+#if defined(__GLIBC__)
+#  include <malloc.h>
+#endif
+
+#ifdef TIMEULAR_COUNT_ALLOCATIONS
+#  include <atomic>
+#  include <cstdlib>
+#  include <new>
+
+namespace {
+    std::atomic<quint64> allocationCount { 0 };
+    std::atomic<quint64> deallocationCount { 0 };
+
+    void *countedAlloc(std::size_t size)
+    {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        return std::malloc(size ? size : 1);
+    }
+
+    void countedFree(void *ptr)
+    {
+        if (!ptr)
+            return;
+        deallocationCount.fetch_add(1, std::memory_order_relaxed);
+        std::free(ptr);
+    }
+}
+
+void *operator new(std::size_t size)
+{
+    if (void *ptr = countedAlloc(size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    return countedAlloc(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    return countedAlloc(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    countedFree(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    countedFree(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept
+{
+    countedFree(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept
+{
+    countedFree(ptr);
+}
+#endif
+
+qint64 ProcessInfo::residentMemory()
+{
+#if defined(Q_OS_LINUX)
+    QFile statm(QStringLiteral("/proc/self/statm"));
+    if (!statm.open(QIODevice::ReadOnly))
+        return -1;
+
+    // size resident shared text lib data dt, in pages
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    if (fields.size() < 2)
+        return -1;
+    return fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE);
+#else
+    return -1;
+#endif
+}
+
+qint64 ProcessInfo::heapInUse()
+{
+#if defined(__GLIBC__)
+#  if __GLIBC_PREREQ(2, 33)
+    const struct mallinfo2 info = mallinfo2();
+    return qint64(info.uordblks) + qint64(info.hblkhd);
+#  else
+    // mallinfo() wraps at 4 GB, far beyond anything this process should use
+    const struct mallinfo info = mallinfo();
+    return qint64(unsigned(info.uordblks)) + qint64(unsigned(info.hblkhd));
+#  endif
+#else
+    return -1;
+#endif
+}
+
+bool ProcessInfo::countsAllocations()
+{
+#ifdef TIMEULAR_COUNT_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+quint64 ProcessInfo::allocations()
+{
+#ifdef TIMEULAR_COUNT_ALLOCATIONS
+    return allocationCount.load(std::memory_order_relaxed);
+#else
+    return 0;
+#endif
+}
+
+quint64 ProcessInfo::deallocations()
+{
+#ifdef TIMEULAR_COUNT_ALLOCATIONS
+    return deallocationCount.load(std::memory_order_relaxed);
+#else
+    return 0;
+#endif
+}
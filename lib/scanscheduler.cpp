@@ -0,0 +1,178 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "scanscheduler.h"
+
+#include <QBluetoothDeviceDiscoveryAgent>
+#include <QDebug>
+#include <QRandomGenerator>
+#include <QTimer>
+
+ScanScheduler::ScanScheduler(QBluetoothDeviceDiscoveryAgent *agent, QObject *parent)
+    : QObject(parent)
+    , m_agent(agent)
+{
+    m_clock.start();
+
+    m_timer = new QTimer(this);
+    m_timer->setSingleShot(true);
+    connect(m_timer, &QTimer::timeout, this, &ScanScheduler::startScan);
+
+    connect(m_agent, &QBluetoothDeviceDiscoveryAgent::finished,
+            this, &ScanScheduler::scanFinished);
+    connect(m_agent, QOverload<QBluetoothDeviceDiscoveryAgent::Error>::of(&QBluetoothDeviceDiscoveryAgent::error),
+            this, [this](QBluetoothDeviceDiscoveryAgent::Error /*error*/) {
+                qWarning() << "Discovery error: " << m_agent->errorString();
+                scanFinished();
+            });
+}
+
+bool ScanScheduler::isActive() const
+{
+    return m_active;
+}
+
+void ScanScheduler::setScanWindow(int msecs)
+{
+    m_scanWindow = qMax(100, msecs);
+}
+
+void ScanScheduler::setIdleScanWindow(int msecs)
+{
+    m_idleScanWindow = qMax(100, msecs);
+}
+
+void ScanScheduler::setMinInterval(int msecs)
+{
+    m_minInterval = qMax(0, msecs);
+}
+
+void ScanScheduler::setMaxInterval(int msecs)
+{
+    m_maxInterval = qMax(m_minInterval, msecs);
+}
+
+void ScanScheduler::setBoostDuration(int msecs)
+{
+    m_boostDuration = qMax(0, msecs);
+}
+
+double ScanScheduler::dutyCycle() const
+{
+    qint64 scanTime = m_scanTime;
+    if (m_scanClock.isValid())
+        scanTime += m_scanClock.elapsed();
+    const qint64 total = m_clock.elapsed();
+    return total > 0 ? double(scanTime) / total : 0.;
+}
+
+quint64 ScanScheduler::wakeups() const
+{
+    return m_wakeups;
+}
+
+void ScanScheduler::start()
+{
+    if (m_active)
+        return;
+
+    m_active = true;
+    emit activeChanged(m_active);
+    startScan();
+}
+
+void ScanScheduler::stop()
+{
+    if (!m_active)
+        return;
+
+    m_active = false;
+    m_timer->stop();
+    if (m_scanClock.isValid()) {
+        m_scanTime += m_scanClock.elapsed();
+        m_scanClock.invalidate();
+    }
+    m_agent->stop();
+    emit activeChanged(m_active);
+    emit statsChanged();
+}
+
+void ScanScheduler::boost()
+{
+    m_boostUntil = m_clock.elapsed() + m_boostDuration;
+    resetBackoff();
+}
+
+void ScanScheduler::resetBackoff()
+{
+    m_interval = 0;
+    if (m_active && m_timer->isActive()) {
+        m_timer->stop();
+        startScan();
+    }
+}
+
+bool ScanScheduler::isBoosted() const
+{
+    return m_clock.elapsed() < m_boostUntil;
+}
+
+void ScanScheduler::startScan()
+{
+    if (!m_active || m_agent->isActive())
+        return;
+
+    m_agent->setLowEnergyDiscoveryTimeout(isBoosted() ? m_scanWindow : m_idleScanWindow);
+    m_agent->start(QBluetoothDeviceDiscoveryAgent::LowEnergyMethod);
+    m_scanClock.start();
+    ++m_wakeups;
+    emit statsChanged();
+}
+
+void ScanScheduler::scanFinished()
+{
+    if (m_scanClock.isValid())
+        m_scanTime += m_scanClock.elapsed();
+    m_scanClock.invalidate();
+    emit statsChanged();
+
+    if (!m_active)
+        return;
+
+    if (isBoosted()) {
+        startScan();
+        return;
+    }
+
+    m_interval = m_interval ? qMin(m_maxInterval, m_interval * 2) : m_minInterval;
+    // +-20% so that several bridges in one room drift apart
+    const int jitter = m_interval / 5;
+    const int delay = m_interval - jitter + int(QRandomGenerator::global()->bounded(2 * jitter + 1));
+    m_timer->start(delay);
+}
@@ -0,0 +1,94 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SCANSCHEDULER_H
+#define SCANSCHEDULER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+
+class QBluetoothDeviceDiscoveryAgent;
+class QTimer;
+
+// Restarts discovery with exponential backoff and jitter instead of scanning
+// back to back. Right after a device was lost it scans continuously for a while.
+class ScanScheduler : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool active READ isActive NOTIFY activeChanged)
+    Q_PROPERTY(double dutyCycle READ dutyCycle NOTIFY statsChanged)
+    Q_PROPERTY(quint64 wakeups READ wakeups NOTIFY statsChanged)
+public:
+    explicit ScanScheduler(QBluetoothDeviceDiscoveryAgent *agent, QObject *parent = nullptr);
+
+    bool isActive() const;
+
+    // length of a scan while boosted and while idle
+    void setScanWindow(int msecs);
+    void setIdleScanWindow(int msecs);
+    // bounds of the pause between idle scans
+    void setMinInterval(int msecs);
+    void setMaxInterval(int msecs);
+    void setBoostDuration(int msecs);
+
+    double dutyCycle() const;
+    quint64 wakeups() const;
+
+public slots:
+    void start();
+    void stop();
+    void boost();
+    void resetBackoff();
+
+signals:
+    void activeChanged(bool active);
+    void statsChanged();
+
+private:
+    void startScan();
+    void scanFinished();
+    bool isBoosted() const;
+
+    QBluetoothDeviceDiscoveryAgent *m_agent;
+    QTimer *m_timer = nullptr;
+    QElapsedTimer m_clock;
+    QElapsedTimer m_scanClock;
+    bool m_active = false;
+    int m_scanWindow = 5000;
+    int m_idleScanWindow = 2000;
+    int m_minInterval = 1000;
+    int m_maxInterval = 60000;
+    int m_boostDuration = 30000;
+    int m_interval = 0;
+    qint64 m_boostUntil = -1;
+    qint64 m_scanTime = 0;
+    quint64 m_wakeups = 0;
+};
+
+#endif // SCANSCHEDULER_H
@@ -0,0 +1,289 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "sessionlog.h"
+
+#include <QDebug>
+#include <QTimer>
+#include <QtEndian>
+
+#include <cstring>
+
+#if defined(Q_OS_WIN)
+#  include <io.h>
+#else
+#  include <unistd.h>
+#endif
+
+namespace {
+    const char magic[4] = { 'Z', 'E', 'I', 'L' };
+    const quint16 version = 1;
+    const quint64 deviceIdMask = Q_UINT64_C(0xffffffffffff);
+
+    void encode(const OrientationEvent &event, uchar *out)
+    {
+        qToLittleEndian<qint64>(event.timestamp, out);
+        qToLittleEndian<quint64>((event.deviceId & deviceIdMask) | (quint64(event.face) << 48), out + 8);
+    }
+
+    OrientationEvent decode(const uchar *in)
+    {
+        OrientationEvent event;
+        event.timestamp = qFromLittleEndian<qint64>(in);
+        const quint64 packed = qFromLittleEndian<quint64>(in + 8);
+        event.deviceId = packed & deviceIdMask;
+        event.face = quint8(packed >> 48);
+        return event;
+    }
+
+    bool validHeader(const uchar *header)
+    {
+        return memcmp(header, magic, sizeof(magic)) == 0
+                && qFromLittleEndian<quint16>(header + 4) == version
+                && qFromLittleEndian<quint16>(header + 6) == SessionLog::RecordSize;
+    }
+
+    void syncToDisk(QFile &file)
+    {
+#if defined(Q_OS_WIN)
+        ::_commit(file.handle());
+#else
+        ::fsync(file.handle());
+#endif
+    }
+}
+
+SessionLogWriter::SessionLogWriter(QObject *parent)
+    : QObject(parent)
+{
+    m_flushTimer = new QTimer(this);
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(1000);
+    connect(m_flushTimer, &QTimer::timeout, this, &SessionLogWriter::flush);
+}
+
+SessionLogWriter::~SessionLogWriter()
+{
+    close();
+}
+
+bool SessionLogWriter::open(const QString &fileName)
+{
+    close();
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        qWarning() << "Cannot open session log" << fileName << m_file.errorString();
+        return false;
+    }
+
+    m_written = 0;
+    m_lastTimestamp = 0;
+    const qint64 size = m_file.size();
+    if (size == 0) {
+        uchar header[SessionLog::HeaderSize] = {};
+        memcpy(header, magic, sizeof(magic));
+        qToLittleEndian<quint16>(version, header + 4);
+        qToLittleEndian<quint16>(SessionLog::RecordSize, header + 6);
+        m_file.write(reinterpret_cast<const char *>(header), sizeof(header));
+    } else {
+        uchar header[SessionLog::HeaderSize];
+        if (size < SessionLog::HeaderSize
+                || m_file.read(reinterpret_cast<char *>(header), sizeof(header)) != sizeof(header)
+                || !validHeader(header)) {
+            qWarning() << "Not a session log" << fileName;
+            m_file.close();
+            return false;
+        }
+
+        // drop a record that was only partially written when we last stopped
+        const qint64 tail = (size - SessionLog::HeaderSize) % SessionLog::RecordSize;
+        if (tail)
+            m_file.resize(size - tail);
+
+        m_written = (size - tail - SessionLog::HeaderSize) / SessionLog::RecordSize;
+        if (m_written > 0) {
+            uchar last[SessionLog::RecordSize];
+            m_file.seek(SessionLog::HeaderSize + (m_written - 1) * SessionLog::RecordSize);
+            if (m_file.read(reinterpret_cast<char *>(last), sizeof(last)) == sizeof(last))
+                m_lastTimestamp = decode(last).timestamp;
+        }
+        m_file.seek(m_file.size());
+    }
+
+    return true;
+}
+
+void SessionLogWriter::close()
+{
+    if (!m_file.isOpen())
+        return;
+
+    flush();
+    m_file.close();
+}
+
+bool SessionLogWriter::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+QString SessionLogWriter::fileName() const
+{
+    return m_file.fileName();
+}
+
+void SessionLogWriter::setFlushInterval(int msecs)
+{
+    m_flushTimer->setInterval(msecs);
+}
+
+void SessionLogWriter::setFlushThreshold(int records)
+{
+    m_flushThreshold = qMax(1, records);
+}
+
+void SessionLogWriter::append(const OrientationEvent &event)
+{
+    if (!m_file.isOpen())
+        return;
+
+    m_pending.append(event);
+    m_lastTimestamp = event.timestamp;
+    if (m_pending.size() >= m_flushThreshold)
+        flush();
+    else if (!m_flushTimer->isActive())
+        m_flushTimer->start();
+}
+
+qint64 SessionLogWriter::count() const
+{
+    return m_written + m_pending.size();
+}
+
+qint64 SessionLogWriter::lastTimestamp() const
+{
+    return m_lastTimestamp;
+}
+
+void SessionLogWriter::flush()
+{
+    m_flushTimer->stop();
+    if (m_pending.isEmpty() || !m_file.isOpen())
+        return;
+
+    QByteArray buffer(m_pending.size() * SessionLog::RecordSize, Qt::Uninitialized);
+    uchar *out = reinterpret_cast<uchar *>(buffer.data());
+    for (const OrientationEvent &event : qAsConst(m_pending)) {
+        encode(event, out);
+        out += SessionLog::RecordSize;
+    }
+    m_pending.clear();
+
+    const qint64 written = m_file.write(buffer);
+    if (written != buffer.size())
+        qWarning() << "Failed writing session log" << m_file.errorString();
+    if (written > 0)
+        m_written += written / SessionLog::RecordSize;
+    m_file.flush();
+    syncToDisk(m_file);
+}
+
+SessionLogReader::SessionLogReader()
+{
+}
+
+SessionLogReader::~SessionLogReader()
+{
+    close();
+}
+
+bool SessionLogReader::open(const QString &fileName)
+{
+    close();
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly))
+        return false;
+
+    const qint64 size = m_file.size();
+    if (size >= SessionLog::HeaderSize)
+        m_data = m_file.map(0, size);
+    if (!m_data || !validHeader(m_data)) {
+        qWarning() << "Not a session log" << fileName;
+        close();
+        return false;
+    }
+
+    m_count = (size - SessionLog::HeaderSize) / SessionLog::RecordSize;
+    return true;
+}
+
+void SessionLogReader::close()
+{
+    if (m_data)
+        m_file.unmap(const_cast<uchar *>(m_data));
+    m_data = nullptr;
+    m_count = 0;
+    m_file.close();
+}
+
+bool SessionLogReader::isOpen() const
+{
+    return m_data != nullptr;
+}
+
+qint64 SessionLogReader::count() const
+{
+    return m_count;
+}
+
+OrientationEvent SessionLogReader::at(qint64 index) const
+{
+    Q_ASSERT(index >= 0 && index < m_count);
+    return decode(m_data + SessionLog::HeaderSize + index * SessionLog::RecordSize);
+}
+
+qint64 SessionLogReader::lowerBound(qint64 timestamp) const
+{
+    qint64 first = 0;
+    qint64 length = m_count;
+    while (length > 0) {
+        const qint64 half = length / 2;
+        const qint64 middle = first + half;
+        const qint64 value = qFromLittleEndian<qint64>(m_data + SessionLog::HeaderSize + middle * SessionLog::RecordSize);
+        if (value < timestamp) {
+            first = middle + 1;
+            length -= half + 1;
+        } else {
+            length = half;
+        }
+    }
+    return first;
+}
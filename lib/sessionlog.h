@@ -0,0 +1,107 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SESSIONLOG_H
+#define SESSIONLOG_H
+
+#include <QObject>
+#include <QFile>
+#include <QVector>
+
+#include "orientationevent.h"
+
+class QTimer;
+
+// On disk a session log is a 16 byte header followed by 16 byte records:
+// little endian msecs since epoch, 48 bit device id, face and a reserved byte.
+namespace SessionLog {
+    enum {
+        HeaderSize = 16,
+        RecordSize = 16
+    };
+}
+
+class SessionLogWriter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SessionLogWriter(QObject *parent = nullptr);
+    ~SessionLogWriter();
+
+    bool open(const QString &fileName);
+    void close();
+    bool isOpen() const;
+    QString fileName() const;
+
+    // records are buffered, then written and synced to disk in batches
+    void setFlushInterval(int msecs);
+    void setFlushThreshold(int records);
+
+    void append(const OrientationEvent &event);
+
+    // records in the log, including those not flushed yet
+    qint64 count() const;
+    // of the last record, 0 for an empty log
+    qint64 lastTimestamp() const;
+
+public slots:
+    void flush();
+
+private:
+    QFile m_file;
+    QTimer *m_flushTimer = nullptr;
+    QVector<OrientationEvent> m_pending;
+    int m_flushThreshold = 64;
+    qint64 m_written = 0;
+    qint64 m_lastTimestamp = 0;
+};
+
+class SessionLogReader
+{
+public:
+    SessionLogReader();
+    ~SessionLogReader();
+
+    bool open(const QString &fileName);
+    void close();
+    bool isOpen() const;
+
+    qint64 count() const;
+    OrientationEvent at(qint64 index) const;
+
+    // index of the first record at or after timestamp, assumes records are in time order
+    qint64 lowerBound(qint64 timestamp) const;
+
+private:
+    QFile m_file;
+    const uchar *m_data = nullptr;
+    qint64 m_count = 0;
+};
+
+#endif // SESSIONLOG_H
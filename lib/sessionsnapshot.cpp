@@ -0,0 +1,100 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "sessionsnapshot.h"
+#include "faceaggregator.h"
+#include "sessionlog.h"
+
+#include <QDataStream>
+#include <QDebug>
+#include <QFile>
+#include <QSaveFile>
+
+namespace {
+    const quint32 magic = 0x5a454953; // "ZEIS"
+    // 2 dropped the utc offset, days are local calendar days now
+    const quint16 version = 2;
+}
+
+QString SessionSnapshot::fileName(const QString &logFileName)
+{
+    return logFileName + QStringLiteral(".snapshot");
+}
+
+bool SessionSnapshot::write(const QString &logFileName, qint64 records, qint64 lastTimestamp,
+                            const FaceAggregator &aggregator)
+{
+    // a crash half way through leaves the previous snapshot in place
+    QSaveFile file(fileName(logFileName));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Cannot write snapshot" << file.fileName() << file.errorString();
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_6);
+    out << magic << version << records << lastTimestamp;
+    aggregator.save(out);
+    if (out.status() != QDataStream::Ok || !file.commit()) {
+        qWarning() << "Failed writing snapshot" << file.fileName() << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+qint64 SessionSnapshot::read(const QString &logFileName, const SessionLogReader &log,
+                             FaceAggregator *aggregator)
+{
+    QFile file(fileName(logFileName));
+    if (!file.open(QIODevice::ReadOnly))
+        return -1;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_6);
+    quint32 fileMagic = 0;
+    quint16 fileVersion = 0;
+    qint64 records = 0;
+    qint64 lastTimestamp = 0;
+    in >> fileMagic >> fileVersion >> records >> lastTimestamp;
+    if (in.status() != QDataStream::Ok || fileMagic != magic || fileVersion != version)
+        return -1;
+
+    // the log was replaced or cut short since, the snapshot is from another history
+    if (records < 0 || records > log.count()
+            || (records > 0 && log.at(records - 1).timestamp != lastTimestamp)) {
+        qDebug() << "Snapshot doesn't match" << logFileName;
+        return -1;
+    }
+
+    if (!aggregator->restore(in)) {
+        qDebug() << "Snapshot not usable" << file.fileName();
+        return -1;
+    }
+    return records;
+}
@@ -0,0 +1,56 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SESSIONSNAPSHOT_H
+#define SESSIONSNAPSHOT_H
+
+#include <QtGlobal>
+#include <QString>
+
+class FaceAggregator;
+class SessionLogReader;
+
+// The aggregator state as of a given number of session log records, kept
+// next to the log as <log>.snapshot and replaced atomically. Loading one
+// leaves only the records after it to replay, however long the log is.
+class SessionSnapshot
+{
+public:
+    static QString fileName(const QString &logFileName);
+
+    // records and lastTimestamp describe the log the state was built from
+    static bool write(const QString &logFileName, qint64 records, qint64 lastTimestamp,
+                      const FaceAggregator &aggregator);
+    // number of records covered by the restored state, -1 if there is no
+    // usable snapshot for this log, the aggregator is left untouched then
+    static qint64 read(const QString &logFileName, const SessionLogReader &log,
+                       FaceAggregator *aggregator);
+};
+
+#endif // SESSIONSNAPSHOT_H
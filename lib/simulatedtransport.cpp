@@ -0,0 +1,150 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "simulatedtransport.h"
+
+#include <QTimer>
+
+namespace {
+    // any non zero handle will do, this is where the ZEI has it
+    const QLowEnergyHandle simulatedOrientationHandle = 0x0025;
+}
+
+SimulatedTransport::SimulatedTransport(QObject *parent)
+    : TimeularTransport(parent)
+{
+    for (int face = 0; face < int(m_values.size()); ++face)
+        m_values[face] = QByteArray(1, char(face));
+}
+
+void SimulatedTransport::connectToDevice()
+{
+    if (m_active)
+        return;
+
+    m_active = true;
+    const quint32 attempt = ++m_attempt;
+    QTimer::singleShot(m_connectLatency, this, [this, attempt]() {
+        // disconnected or reconnected in the meantime
+        if (attempt == m_attempt && m_active)
+            linkUp();
+    });
+}
+
+void SimulatedTransport::disconnectFromDevice()
+{
+    dropLink();
+}
+
+void SimulatedTransport::readOrientation()
+{
+    if (!m_subscribed)
+        return;
+
+    emit orientationRead(simulatedOrientationHandle, value());
+}
+
+void SimulatedTransport::readBattery()
+{
+    if (!m_subscribed)
+        return;
+
+    // answered later, like a real read
+    const quint32 attempt = m_attempt;
+    QTimer::singleShot(0, this, [this, attempt]() {
+        if (attempt == m_attempt && m_subscribed)
+            emit batteryRead(m_batteryLevel);
+    });
+}
+
+int SimulatedTransport::connectLatency() const
+{
+    return m_connectLatency;
+}
+
+void SimulatedTransport::setConnectLatency(int msecs)
+{
+    m_connectLatency = qMax(0, msecs);
+}
+
+bool SimulatedTransport::isSubscribed() const
+{
+    return m_subscribed;
+}
+
+int SimulatedTransport::face() const
+{
+    return m_face;
+}
+
+int SimulatedTransport::batteryLevel() const
+{
+    return m_batteryLevel;
+}
+
+void SimulatedTransport::setBatteryLevel(int percent)
+{
+    m_batteryLevel = qBound(0, percent, 100);
+}
+
+void SimulatedTransport::setFace(int face)
+{
+    m_face = face;
+    if (!m_subscribed)
+        return;
+
+    emit notificationReceived(simulatedOrientationHandle, value());
+}
+
+void SimulatedTransport::dropLink()
+{
+    m_subscribed = false;
+    if (m_active) {
+        m_active = false;
+        emit disconnected();
+    }
+}
+
+QByteArray SimulatedTransport::value() const
+{
+    if (m_face >= 0 && m_face < int(m_values.size()))
+        return m_values[m_face];
+    return QByteArray(1, char(m_face));
+}
+
+void SimulatedTransport::linkUp()
+{
+    emit connected();
+    emit serviceDiscovered();
+    emit detailsDiscovered();
+    emit subscribed(simulatedOrientationHandle);
+    m_subscribed = true;
+    readOrientation();
+    emit notificationsEnabled();
+}
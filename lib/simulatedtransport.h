@@ -0,0 +1,80 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SIMULATEDTRANSPORT_H
+#define SIMULATEDTRANSPORT_H
+
+#include <array>
+
+#include "timeulartransport.h"
+
+// A transport without a radio. It walks through the same signals as a BLE
+// link would, and faces are fed in by whoever drives the simulation.
+class SimulatedTransport : public TimeularTransport
+{
+    Q_OBJECT
+public:
+    explicit SimulatedTransport(QObject *parent = nullptr);
+
+    void connectToDevice() override;
+    void disconnectFromDevice() override;
+    void readOrientation() override;
+    void readBattery() override;
+
+    // msecs from connectToDevice() until notifications are enabled
+    int connectLatency() const;
+    void setConnectLatency(int msecs);
+
+    bool isSubscribed() const;
+    int face() const;
+    int batteryLevel() const;
+    void setBatteryLevel(int percent);
+
+    // delivered as a notification, ignored unless subscribed
+    void setFace(int face);
+    // ends the link as if the die went out of range
+    void dropLink();
+
+private:
+    void linkUp();
+    QByteArray value() const;
+
+    // one shared value per face, so a notification doesn't allocate where a
+    // radio wouldn't come into it
+    std::array<QByteArray, 9> m_values;
+
+    int m_connectLatency = 0;
+    int m_face = 0;
+    int m_batteryLevel = 100;
+    quint32 m_attempt = 0;
+    bool m_active = false;
+    bool m_subscribed = false;
+};
+
+#endif // SIMULATEDTRANSPORT_H
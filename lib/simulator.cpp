@@ -0,0 +1,229 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "simulator.h"
+#include "deviceprofile.h"
+#include "simulatedtransport.h"
+#include "timeulardevice.h"
+#include "timeularpool.h"
+
+#include <QBluetoothAddress>
+#include <QBluetoothDeviceInfo>
+#include <QDebug>
+#include <QRandomGenerator>
+#include <QTimer>
+
+namespace {
+    // locally administered range, can't collide with a real die
+    const quint64 simulatedAddressBase = Q_UINT64_C(0xC2A500000000);
+
+    // keeps a stalled event loop from being flooded when it catches up
+    const int maxEventsPerTick = 1000;
+}
+
+Simulator::Simulator(QObject *parent)
+    : QObject(parent)
+{
+    m_timer = new QTimer(this);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    m_timer->setInterval(1);
+    connect(m_timer, &QTimer::timeout, this, &Simulator::tick);
+}
+
+Simulator::~Simulator()
+{
+}
+
+void Simulator::attach(TimeularPool *pool, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        const quint64 index = quint64(m_transports.size());
+        QBluetoothDeviceInfo info(QBluetoothAddress(simulatedAddressBase | index),
+                                  QLatin1String(ZeiProfile::advertisedName), 0);
+        info.setCoreConfigurations(QBluetoothDeviceInfo::LowEnergyCoreConfiguration);
+
+        SimulatedTransport *transport = new SimulatedTransport;
+        transport->setConnectLatency(m_connectLatency);
+        m_transports.append(transport);
+        pool->addDevice(info, transport);
+    }
+}
+
+double Simulator::rate() const
+{
+    return m_rate;
+}
+
+void Simulator::setRate(double eventsPerSecond)
+{
+    m_rate = qMax(0.0, eventsPerSecond);
+    // restart the schedule so a new rate doesn't burst to catch up
+    m_startedAt = m_generated;
+    m_dropsStartedAt = m_dropped;
+    m_clock.restart();
+}
+
+int Simulator::connectLatency() const
+{
+    return m_connectLatency;
+}
+
+void Simulator::setConnectLatency(int msecs)
+{
+    m_connectLatency = qMax(0, msecs);
+    for (SimulatedTransport *transport : qAsConst(m_transports)) {
+        if (transport)
+            transport->setConnectLatency(m_connectLatency);
+    }
+}
+
+double Simulator::dropRate() const
+{
+    return m_dropRate;
+}
+
+void Simulator::setDropRate(double dropsPerSecond)
+{
+    m_dropRate = qMax(0.0, dropsPerSecond);
+    m_dropsStartedAt = m_dropped;
+    m_startedAt = m_generated;
+    m_clock.restart();
+}
+
+bool Simulator::setReplayLog(const QString &fileName)
+{
+    m_replayIndex = 0;
+    m_replayDevices.clear();
+    if (!m_replay.open(fileName)) {
+        qWarning() << "Can't replay" << fileName;
+        return false;
+    }
+    return true;
+}
+
+bool Simulator::isRunning() const
+{
+    return m_timer->isActive();
+}
+
+quint64 Simulator::generated() const
+{
+    return m_generated;
+}
+
+quint64 Simulator::dropped() const
+{
+    return m_dropped;
+}
+
+void Simulator::start()
+{
+    if (m_timer->isActive())
+        return;
+
+    m_startedAt = m_generated;
+    m_dropsStartedAt = m_dropped;
+    m_clock.start();
+    m_timer->start();
+    emit runningChanged(true);
+}
+
+void Simulator::stop()
+{
+    if (!m_timer->isActive())
+        return;
+
+    m_timer->stop();
+    emit runningChanged(false);
+}
+
+void Simulator::tick()
+{
+    if (m_transports.isEmpty())
+        return;
+
+    const quint64 due = m_startedAt + quint64(m_clock.elapsed() * m_rate / 1000.0);
+    const int count = int(qMin<quint64>(due - qMin(due, m_generated), maxEventsPerTick));
+    for (int i = 0; i < count; ++i) {
+        if (m_replay.isOpen())
+            replayStep();
+        else
+            randomStep();
+        ++m_generated;
+    }
+    const quint64 dropsDue = m_dropsStartedAt + quint64(m_clock.elapsed() * m_dropRate / 1000.0);
+    while (m_dropped < dropsDue) {
+        dropStep();
+        ++m_dropped;
+    }
+
+    if (due > m_generated + maxEventsPerTick) {
+        // falling behind, drop the backlog instead of growing it
+        m_startedAt = m_generated;
+        m_dropsStartedAt = m_dropped;
+        m_clock.restart();
+    }
+}
+
+void Simulator::dropStep()
+{
+    SimulatedTransport *transport = m_transports.at(int(QRandomGenerator::global()->bounded(m_transports.size())));
+    // the device's supervisor brings the link back up
+    if (transport && transport->isSubscribed())
+        transport->dropLink();
+}
+
+void Simulator::randomStep()
+{
+    QRandomGenerator *random = QRandomGenerator::global();
+    SimulatedTransport *transport = m_transports.at(int(random->bounded(m_transports.size())));
+    if (!transport)
+        return;
+
+    // any other face, vertical included
+    const int face = (transport->face() + 1 + int(random->bounded(8))) % 9;
+    transport->setFace(face);
+}
+
+void Simulator::replayStep()
+{
+    if (m_replay.count() == 0)
+        return;
+    if (m_replayIndex >= m_replay.count())
+        m_replayIndex = 0;
+
+    const OrientationEvent event = m_replay.at(m_replayIndex++);
+    auto it = m_replayDevices.find(event.deviceId);
+    if (it == m_replayDevices.end())
+        it = m_replayDevices.insert(event.deviceId, m_replayDevices.size() % m_transports.size());
+
+    SimulatedTransport *transport = m_transports.at(it.value());
+    if (transport)
+        transport->setFace(event.face);
+}
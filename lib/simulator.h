@@ -0,0 +1,104 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QPointer>
+#include <QVector>
+
+#include "sessionlog.h"
+
+class QTimer;
+class SimulatedTransport;
+class TimeularPool;
+
+// Drives a number of virtual dice in a TimeularPool, either with a random
+// walk over the faces or by replaying a session log. Events are spread over
+// time at a fixed total rate so the whole pipeline runs under real load.
+class Simulator : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool running READ isRunning NOTIFY runningChanged)
+public:
+    explicit Simulator(QObject *parent = nullptr);
+    ~Simulator();
+
+    // adds count virtual devices to the pool, which owns them from then on
+    void attach(TimeularPool *pool, int count);
+
+    // total events per second across all devices
+    double rate() const;
+    void setRate(double eventsPerSecond);
+    int connectLatency() const;
+    void setConnectLatency(int msecs);
+    // links dropped per second across all devices, for soak runs
+    double dropRate() const;
+    void setDropRate(double dropsPerSecond);
+
+    // replays the log instead of a random walk, devices in the log are
+    // mapped onto the virtual ones in order of appearance
+    bool setReplayLog(const QString &fileName);
+
+    bool isRunning() const;
+    quint64 generated() const;
+    quint64 dropped() const;
+
+public slots:
+    void start();
+    void stop();
+
+signals:
+    void runningChanged(bool running);
+
+private:
+    void tick();
+    void randomStep();
+    void replayStep();
+    void dropStep();
+
+    QVector<QPointer<SimulatedTransport>> m_transports;
+    QTimer *m_timer = nullptr;
+    QElapsedTimer m_clock;
+    double m_rate = 10;
+    int m_connectLatency = 50;
+    quint64 m_generated = 0;
+    quint64 m_startedAt = 0;
+    double m_dropRate = 0;
+    quint64 m_dropped = 0;
+    quint64 m_dropsStartedAt = 0;
+    SessionLogReader m_replay;
+    qint64 m_replayIndex = 0;
+    QHash<quint64, int> m_replayDevices;
+};
+
+#endif // SIMULATOR_H
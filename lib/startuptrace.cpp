@@ -0,0 +1,94 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "startuptrace.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QStringList>
+
+#include <atomic>
+
+namespace {
+    const char *const milestoneNames[StartupTrace::MilestoneCount] = {
+        "discovery started",
+        "qml loaded",
+        "first frame",
+        "connected",
+        "first orientation"
+    };
+
+    struct Trace {
+        Trace() { for (std::atomic<qint64> &t : reached) t.store(-1); }
+
+        QElapsedTimer clock;
+        std::atomic<qint64> reached[StartupTrace::MilestoneCount];
+    };
+
+    Trace &trace()
+    {
+        static Trace instance;
+        return instance;
+    }
+}
+
+void StartupTrace::start()
+{
+    if (!trace().clock.isValid())
+        trace().clock.start();
+}
+
+void StartupTrace::mark(Milestone milestone)
+{
+    Trace &t = trace();
+    if (t.reached[milestone].load(std::memory_order_relaxed) >= 0)
+        return;
+
+    start();
+    qint64 unset = -1;
+    const qint64 now = t.clock.elapsed();
+    if (t.reached[milestone].compare_exchange_strong(unset, now))
+        qInfo().nospace() << "Startup: " << milestoneNames[milestone] << " after " << now << " ms";
+}
+
+qint64 StartupTrace::elapsed(Milestone milestone)
+{
+    return trace().reached[milestone].load();
+}
+
+QString StartupTrace::report()
+{
+    QStringList parts;
+    for (int i = 0; i < MilestoneCount; ++i) {
+        const qint64 reached = trace().reached[i].load();
+        if (reached >= 0)
+            parts.append(QStringLiteral("%1 %2 ms").arg(QLatin1String(milestoneNames[i])).arg(reached));
+    }
+    return parts.join(QLatin1String(", "));
+}
@@ -0,0 +1,183 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "telemetryscheduler.h"
+#include "timeulardevice.h"
+
+#include <QTimer>
+
+TelemetryScheduler::TelemetryScheduler(QObject *parent)
+    : QObject(parent)
+{
+    m_clock.start();
+    m_timer = new QTimer(this);
+    // telemetry is never urgent, let the timer be batched with other wakeups
+    m_timer->setTimerType(Qt::VeryCoarseTimer);
+    m_timer->setInterval(5000);
+    connect(m_timer, &QTimer::timeout,
+            this, &TelemetryScheduler::tick);
+}
+
+bool TelemetryScheduler::isEnabled() const
+{
+    return m_enabled;
+}
+
+void TelemetryScheduler::setEnabled(bool enabled)
+{
+    if (enabled == m_enabled)
+        return;
+
+    m_enabled = enabled;
+    updateTimer();
+    emit enabledChanged(m_enabled);
+}
+
+int TelemetryScheduler::interval() const
+{
+    return m_timer->interval();
+}
+
+void TelemetryScheduler::setInterval(int msecs)
+{
+    m_timer->setInterval(qMax(1000, msecs));
+}
+
+int TelemetryScheduler::batteryPeriod() const
+{
+    return m_batteryPeriod;
+}
+
+void TelemetryScheduler::setBatteryPeriod(int msecs)
+{
+    m_batteryPeriod = qMax(0, msecs);
+}
+
+int TelemetryScheduler::quietTime() const
+{
+    return m_quietTime;
+}
+
+void TelemetryScheduler::setQuietTime(int msecs)
+{
+    m_quietTime = qMax(0, msecs);
+}
+
+quint64 TelemetryScheduler::reads() const
+{
+    return m_reads;
+}
+
+quint64 TelemetryScheduler::deferred() const
+{
+    return m_deferred;
+}
+
+void TelemetryScheduler::addDevice(TimeularDevice *device)
+{
+    if (entry(device))
+        return;
+
+    Entry added;
+    added.device = device;
+    m_entries.append(added);
+
+    connect(device, &TimeularDevice::statusChanged,
+            this, [this, device](TimeularDevice::Status status) {
+                // a fresh link is read again once it settles
+                if (status != TimeularDevice::Connected) {
+                    if (Entry *e = entry(device))
+                        e->lastRead = -1;
+                }
+            });
+    connect(device, &QObject::destroyed,
+            this, [this, device]() { removeDevice(device); });
+    updateTimer();
+}
+
+void TelemetryScheduler::removeDevice(TimeularDevice *device)
+{
+    for (int i = 0; i < m_entries.size(); ++i) {
+        if (m_entries.at(i).device == device) {
+            m_entries.remove(i);
+            break;
+        }
+    }
+    device->disconnect(this);
+    updateTimer();
+}
+
+TelemetryScheduler::Entry *TelemetryScheduler::entry(TimeularDevice *device)
+{
+    for (Entry &e : m_entries) {
+        if (e.device == device)
+            return &e;
+    }
+    return nullptr;
+}
+
+void TelemetryScheduler::updateTimer()
+{
+    if (m_enabled && !m_entries.isEmpty()) {
+        if (!m_timer->isActive())
+            m_timer->start();
+    } else {
+        m_timer->stop();
+    }
+}
+
+void TelemetryScheduler::tick()
+{
+    const qint64 now = m_clock.elapsed();
+    Entry *next = nullptr;
+    bool deferred = false;
+    for (Entry &e : m_entries) {
+        if (e.device->status() != TimeularDevice::Connected)
+            continue;
+        if (e.lastRead >= 0 && now - e.lastRead < m_batteryPeriod)
+            continue;
+        if (e.device->msecsSinceActivity() < m_quietTime) {
+            deferred = true;
+            continue;
+        }
+        // the longest overdue goes first, never read counts as the longest
+        if (!next || e.lastRead < next->lastRead)
+            next = &e;
+    }
+
+    if (deferred)
+        ++m_deferred;
+    if (next) {
+        next->lastRead = now;
+        ++m_reads;
+        next->device->readBattery();
+    }
+    if (deferred || next)
+        emit statsChanged();
+}
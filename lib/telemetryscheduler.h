@@ -0,0 +1,97 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef TELEMETRYSCHEDULER_H
+#define TELEMETRYSCHEDULER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QVector>
+
+class QTimer;
+class TimeularDevice;
+
+// Reads the battery level of connected dice in the background. All dice
+// share one rate limited timer that issues at most one read per interval,
+// and a die is only asked while its link has been quiet, never in the
+// middle of a flurry of flips or the subscription setup.
+class TelemetryScheduler : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool enabled READ isEnabled WRITE setEnabled NOTIFY enabledChanged)
+    Q_PROPERTY(quint64 reads READ reads NOTIFY statsChanged)
+    Q_PROPERTY(quint64 deferred READ deferred NOTIFY statsChanged)
+public:
+    explicit TelemetryScheduler(QObject *parent = nullptr);
+
+    bool isEnabled() const;
+    void setEnabled(bool enabled);
+
+    // pause between two reads, of any die
+    int interval() const;
+    void setInterval(int msecs);
+    // how often each die is read
+    int batteryPeriod() const;
+    void setBatteryPeriod(int msecs);
+    // how long a link has to be idle before it is read
+    int quietTime() const;
+    void setQuietTime(int msecs);
+
+    quint64 reads() const;
+    // ticks on which a due die was skipped because its link was busy
+    quint64 deferred() const;
+
+    void addDevice(TimeularDevice *device);
+    void removeDevice(TimeularDevice *device);
+
+signals:
+    void enabledChanged(bool enabled);
+    void statsChanged();
+
+private:
+    struct Entry {
+        TimeularDevice *device = nullptr;
+        qint64 lastRead = -1;   // on m_clock, -1 for never on this link
+    };
+
+    void tick();
+    void updateTimer();
+    Entry *entry(TimeularDevice *device);
+
+    QTimer *m_timer = nullptr;
+    QElapsedTimer m_clock;
+    QVector<Entry> m_entries;
+    int m_batteryPeriod = 15 * 60 * 1000;
+    int m_quietTime = 2000;
+    bool m_enabled = true;
+    quint64 m_reads = 0;
+    quint64 m_deferred = 0;
+};
+
+#endif // TELEMETRYSCHEDULER_H
@@ -0,0 +1,198 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "threadedtimeularmanager.h"
+
+#include <QThread>
+
+ThreadedTimeularManager::ThreadedTimeularManager(QObject *parent)
+    : QObject(parent)
+    , m_pendingStatus(TimeularManager::Disconneted)
+    , m_pendingOrientation(TimeularManager::Vertical)
+    , m_pendingStableOrientation(TimeularManager::Vertical)
+    , m_updatePending(false)
+{
+    m_thread = new QThread(this);
+    m_thread->setObjectName(QStringLiteral("Timeular BLE"));
+    m_context = new QObject;
+    m_context->moveToThread(m_thread);
+    m_thread->start();
+
+    // the Bluetooth backends create helper objects of their own, so the
+    // manager has to be constructed on the thread it runs on
+    QMetaObject::invokeMethod(m_context, [this]() {
+        m_manager = new TimeularManager;
+        connect(m_manager, &TimeularManager::statusChanged,
+                m_manager, [this](TimeularManager::Status status) {
+                    m_pendingStatus = status;
+                    scheduleUpdate();
+                });
+        connect(m_manager, &TimeularManager::orientationChanged,
+                m_manager, [this](TimeularManager::Orientation orientation) {
+                    m_pendingOrientation = orientation;
+                    scheduleUpdate();
+                });
+        connect(m_manager, &TimeularManager::stableOrientationChanged,
+                m_manager, [this](TimeularManager::Orientation orientation) {
+                    m_pendingStableOrientation = orientation;
+                    scheduleUpdate();
+                });
+        // rare, a plain queued signal each is fine
+        connect(m_manager, &TimeularManager::sessionLogChanged,
+                this, [this](const QString &fileName) {
+                    if (fileName != m_sessionLog) {
+                        m_sessionLog = fileName;
+                        emit sessionLogChanged(m_sessionLog);
+                    }
+                });
+    }, Qt::QueuedConnection);
+}
+
+ThreadedTimeularManager::~ThreadedTimeularManager()
+{
+    QMetaObject::invokeMethod(m_context, [this]() {
+        delete m_manager;
+        m_manager = nullptr;
+    }, Qt::BlockingQueuedConnection);
+
+    m_thread->quit();
+    m_thread->wait();
+    delete m_context;
+}
+
+TimeularManager::Status ThreadedTimeularManager::status() const
+{
+    return m_status;
+}
+
+TimeularManager::Orientation ThreadedTimeularManager::orientation() const
+{
+    return m_orientation;
+}
+
+TimeularManager::Orientation ThreadedTimeularManager::stableOrientation() const
+{
+    return m_stableOrientation;
+}
+
+TimeularState ThreadedTimeularManager::state() const
+{
+    TimeularState state;
+    state.status = m_status;
+    state.orientation = m_orientation;
+    state.stableOrientation = m_stableOrientation;
+    return state;
+}
+
+QString ThreadedTimeularManager::sessionLog() const
+{
+    return m_sessionLog;
+}
+
+void ThreadedTimeularManager::setSessionLog(const QString &fileName)
+{
+    // confirmed by the worker through sessionLogChanged, opening may fail
+    QMetaObject::invokeMethod(m_context, [this, fileName]() {
+        m_manager->setSessionLog(fileName);
+    }, Qt::QueuedConnection);
+}
+
+bool ThreadedTimeularManager::isStatsEnabled() const
+{
+    return m_statsEnabled;
+}
+
+void ThreadedTimeularManager::setStatsEnabled(bool enabled)
+{
+    if (enabled == m_statsEnabled)
+        return;
+
+    m_statsEnabled = enabled;
+    QMetaObject::invokeMethod(m_context, [this, enabled]() {
+        m_manager->stats()->setEnabled(enabled);
+    }, Qt::QueuedConnection);
+    emit statsEnabledChanged(m_statsEnabled);
+}
+
+QVariantList ThreadedTimeularManager::statsSummary() const
+{
+    QVariantList summary;
+    QMetaObject::invokeMethod(m_context, [this, &summary]() {
+        summary = m_manager->stats()->summary();
+    }, Qt::BlockingQueuedConnection);
+    return summary;
+}
+
+QString ThreadedTimeularManager::statsReport() const
+{
+    QString report;
+    QMetaObject::invokeMethod(m_context, [this, &report]() {
+        report = m_manager->stats()->report();
+    }, Qt::BlockingQueuedConnection);
+    return report;
+}
+
+void ThreadedTimeularManager::startDiscovery()
+{
+    QMetaObject::invokeMethod(m_context, [this]() {
+        m_manager->startDiscovery();
+    }, Qt::QueuedConnection);
+}
+
+void ThreadedTimeularManager::scheduleUpdate()
+{
+    // called on the worker thread, only the first change of a burst posts an event
+    if (!m_updatePending.exchange(true))
+        QMetaObject::invokeMethod(this, [this]() { applyUpdate(); }, Qt::QueuedConnection);
+}
+
+void ThreadedTimeularManager::applyUpdate()
+{
+    m_updatePending = false;
+
+    const auto status = static_cast<TimeularManager::Status>(m_pendingStatus.load());
+    const auto orientation = static_cast<TimeularManager::Orientation>(m_pendingOrientation.load());
+    const auto stableOrientation = static_cast<TimeularManager::Orientation>(m_pendingStableOrientation.load());
+
+    const TimeularState before = state();
+    if (status != m_status) {
+        m_status = status;
+        emit statusChanged(m_status);
+    }
+    if (orientation != m_orientation) {
+        m_orientation = orientation;
+        emit orientationChanged(m_orientation);
+    }
+    if (stableOrientation != m_stableOrientation) {
+        m_stableOrientation = stableOrientation;
+        emit stableOrientationChanged(m_stableOrientation);
+    }
+    if (state() != before)
+        emit stateChanged();
+}
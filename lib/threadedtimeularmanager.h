@@ -0,0 +1,103 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef THREADEDTIMEULARMANAGER_H
+#define THREADEDTIMEULARMANAGER_H
+
+#include <QObject>
+#include <QVariantList>
+
+#include <atomic>
+
+#include "timeularmanager.h"
+
+class QThread;
+
+// Runs a TimeularManager and the whole BLE stack on a worker thread. State
+// changes reach this object's thread as at most one queued call per burst.
+// The stats live on the worker thread too, they are only reachable through
+// calls that wait for it.
+class ThreadedTimeularManager : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(TimeularManager::Status status READ status NOTIFY statusChanged)
+    Q_PROPERTY(TimeularManager::Orientation orientation READ orientation NOTIFY orientationChanged)
+    Q_PROPERTY(TimeularManager::Orientation stableOrientation READ stableOrientation NOTIFY stableOrientationChanged)
+    Q_PROPERTY(TimeularState state READ state NOTIFY stateChanged)
+    Q_PROPERTY(QString sessionLog READ sessionLog WRITE setSessionLog NOTIFY sessionLogChanged)
+    Q_PROPERTY(bool statsEnabled READ isStatsEnabled WRITE setStatsEnabled NOTIFY statsEnabledChanged)
+public:
+    explicit ThreadedTimeularManager(QObject *parent = nullptr);
+    ~ThreadedTimeularManager();
+
+    TimeularManager::Status status() const;
+    TimeularManager::Orientation orientation() const;
+    TimeularManager::Orientation stableOrientation() const;
+    TimeularState state() const;
+    QString sessionLog() const;
+    void setSessionLog(const QString &fileName);
+    bool isStatsEnabled() const;
+    void setStatsEnabled(bool enabled);
+
+    // TimeularStats::summary() and report(), waiting for the worker thread
+    Q_INVOKABLE QVariantList statsSummary() const;
+    Q_INVOKABLE QString statsReport() const;
+
+public slots:
+    void startDiscovery();
+
+signals:
+    void statusChanged(TimeularManager::Status status);
+    void orientationChanged(TimeularManager::Orientation orientation);
+    void stableOrientationChanged(TimeularManager::Orientation orientation);
+    void stateChanged();
+    void sessionLogChanged(const QString &fileName);
+    void statsEnabledChanged(bool enabled);
+
+private:
+    void scheduleUpdate();
+    void applyUpdate();
+
+    QThread *m_thread = nullptr;
+    QObject *m_context = nullptr;
+    TimeularManager *m_manager = nullptr;   // only touched on m_thread
+
+    std::atomic<int> m_pendingStatus;
+    std::atomic<int> m_pendingOrientation;
+    std::atomic<int> m_pendingStableOrientation;
+    std::atomic<bool> m_updatePending;
+
+    TimeularManager::Status m_status = TimeularManager::Disconneted;
+    TimeularManager::Orientation m_orientation = TimeularManager::Vertical;
+    TimeularManager::Orientation m_stableOrientation = TimeularManager::Vertical;
+    QString m_sessionLog;
+    bool m_statsEnabled = false;
+};
+
+#endif // THREADEDTIMEULARMANAGER_H
@@ -0,0 +1,197 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "timeularbroker.h"
+#include "brokerprotocol.h"
+#include "timeularmanager.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QLocalServer>
+#include <QLocalSocket>
+
+namespace {
+    // a client this far behind isn't reading, drop it instead of buffering forever
+    const qint64 maxPendingBytes = 64 * 1024;
+}
+
+TimeularBroker::TimeularBroker(QObject *parent)
+    : QObject(parent)
+{
+    m_server = new QLocalServer(this);
+    connect(m_server, &QLocalServer::newConnection,
+            this, &TimeularBroker::newConnection);
+}
+
+TimeularBroker::~TimeularBroker()
+{
+    close();
+}
+
+bool TimeularBroker::listen(const QString &name)
+{
+    // a broker that crashed leaves its socket file behind
+    QLocalServer::removeServer(name);
+    if (!m_server->listen(name)) {
+        qWarning() << "Can't listen on" << name << m_server->errorString();
+        return false;
+    }
+    return true;
+}
+
+void TimeularBroker::close()
+{
+    m_server->close();
+    const QVector<QLocalSocket *> clients = m_clients;
+    for (QLocalSocket *client : clients)
+        removeClient(client);
+}
+
+QString TimeularBroker::serverName() const
+{
+    return m_server->fullServerName();
+}
+
+int TimeularBroker::clientCount() const
+{
+    return m_clients.size();
+}
+
+void TimeularBroker::attach(TimeularManager *manager)
+{
+    if (m_manager)
+        m_manager->disconnect(this);
+
+    m_manager = manager;
+    if (!m_manager)
+        return;
+
+    connect(m_manager, &TimeularManager::statusChanged,
+            this, &TimeularBroker::statusChanged);
+    connect(m_manager, &TimeularManager::orientationChanged,
+            this, &TimeularBroker::orientationChanged);
+    connect(m_manager, &TimeularManager::stableOrientationChanged,
+            this, &TimeularBroker::stableOrientationChanged);
+}
+
+void TimeularBroker::newConnection()
+{
+    while (QLocalSocket *client = m_server->nextPendingConnection()) {
+        m_clients.append(client);
+        connect(client, &QLocalSocket::disconnected,
+                this, [this, client]() { removeClient(client); });
+        sendState(client);
+        emit clientCountChanged(m_clients.size());
+    }
+}
+
+void TimeularBroker::removeClient(QLocalSocket *client)
+{
+    if (!m_clients.removeOne(client))
+        return;
+
+    client->disconnect(this);
+    client->abort();
+    client->deleteLater();
+    emit clientCountChanged(m_clients.size());
+}
+
+void TimeularBroker::sendState(QLocalSocket *client)
+{
+    uchar frame[BrokerProtocol::MaxFrameSize];
+    BrokerProtocol::encodeHello(frame);
+    write(client, frame, BrokerProtocol::HelloSize);
+    if (!m_manager)
+        return;
+
+    BrokerProtocol::encodeStatus(m_manager->deviceId(), quint8(m_manager->status()), frame);
+    write(client, frame, BrokerProtocol::StatusSize);
+
+    OrientationEvent event;
+    event.timestamp = m_manager->stableSince();
+    event.deviceId = m_manager->deviceId();
+    event.face = quint8(m_manager->stableOrientation());
+    BrokerProtocol::encodeEvent(BrokerProtocol::StableOrientation, event, frame);
+    write(client, frame, BrokerProtocol::EventSize);
+    event.timestamp = QDateTime::currentMSecsSinceEpoch();
+    event.face = quint8(m_manager->orientation());
+    BrokerProtocol::encodeEvent(BrokerProtocol::Orientation, event, frame);
+    write(client, frame, BrokerProtocol::EventSize);
+}
+
+void TimeularBroker::broadcast(const uchar *frame, int size)
+{
+    const QVector<QLocalSocket *> clients = m_clients;
+    for (QLocalSocket *client : clients)
+        write(client, frame, size);
+}
+
+void TimeularBroker::write(QLocalSocket *client, const uchar *frame, int size)
+{
+    if (client->bytesToWrite() > maxPendingBytes) {
+        qWarning() << "Dropping broker client that stopped reading";
+        removeClient(client);
+        return;
+    }
+
+    client->write(reinterpret_cast<const char *>(frame), size);
+    // hand it to the kernel now rather than on the next event loop pass
+    client->flush();
+}
+
+void TimeularBroker::statusChanged()
+{
+    uchar frame[BrokerProtocol::StatusSize];
+    BrokerProtocol::encodeStatus(m_manager->deviceId(), quint8(m_manager->status()), frame);
+    broadcast(frame, sizeof(frame));
+}
+
+void TimeularBroker::orientationChanged()
+{
+    OrientationEvent event;
+    event.timestamp = QDateTime::currentMSecsSinceEpoch();
+    event.deviceId = m_manager->deviceId();
+    event.face = quint8(m_manager->orientation());
+
+    uchar frame[BrokerProtocol::EventSize];
+    BrokerProtocol::encodeEvent(BrokerProtocol::Orientation, event, frame);
+    broadcast(frame, sizeof(frame));
+}
+
+void TimeularBroker::stableOrientationChanged()
+{
+    OrientationEvent event;
+    event.timestamp = m_manager->stableSince();
+    event.deviceId = m_manager->deviceId();
+    event.face = quint8(m_manager->stableOrientation());
+
+    uchar frame[BrokerProtocol::EventSize];
+    BrokerProtocol::encodeEvent(BrokerProtocol::StableOrientation, event, frame);
+    broadcast(frame, sizeof(frame));
+}
@@ -0,0 +1,78 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef TIMEULARBROKER_H
+#define TIMEULARBROKER_H
+
+#include <QObject>
+#include <QVector>
+
+#include "orientationevent.h"
+
+class QLocalServer;
+class QLocalSocket;
+class TimeularManager;
+
+// Shares one manager's connection with other processes on the same host.
+// Clients connect to a local socket and get the current state followed by
+// every change, see BrokerProtocol for the framing.
+class TimeularBroker : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int clientCount READ clientCount NOTIFY clientCountChanged)
+public:
+    explicit TimeularBroker(QObject *parent = nullptr);
+    ~TimeularBroker();
+
+    bool listen(const QString &name);
+    void close();
+    QString serverName() const;
+    int clientCount() const;
+
+    void attach(TimeularManager *manager);
+
+signals:
+    void clientCountChanged(int count);
+
+private:
+    void newConnection();
+    void removeClient(QLocalSocket *client);
+    void sendState(QLocalSocket *client);
+    void broadcast(const uchar *frame, int size);
+    void write(QLocalSocket *client, const uchar *frame, int size);
+    void statusChanged();
+    void orientationChanged();
+    void stableOrientationChanged();
+
+    QLocalServer *m_server = nullptr;
+    QVector<QLocalSocket *> m_clients;
+    TimeularManager *m_manager = nullptr;
+};
+
+#endif // TIMEULARBROKER_H
@@ -0,0 +1,201 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "timeularbrokerclient.h"
+#include "brokerprotocol.h"
+
+#include <QDebug>
+#include <QLocalSocket>
+#include <QTimer>
+
+TimeularBrokerClient::TimeularBrokerClient(QObject *parent)
+    : QObject(parent)
+    , m_serverName(QStringLiteral("timeular"))
+{
+    m_socket = new QLocalSocket(this);
+    connect(m_socket, &QLocalSocket::readyRead,
+            this, &TimeularBrokerClient::readFrames);
+    connect(m_socket, &QLocalSocket::disconnected,
+            this, &TimeularBrokerClient::socketDisconnected);
+    connect(m_socket, QOverload<QLocalSocket::LocalSocketError>::of(&QLocalSocket::error),
+            this, &TimeularBrokerClient::socketDisconnected);
+
+    m_retryTimer = new QTimer(this);
+    m_retryTimer->setSingleShot(true);
+    m_retryTimer->setInterval(1000);
+    connect(m_retryTimer, &QTimer::timeout,
+            this, &TimeularBrokerClient::connectToBroker);
+}
+
+QString TimeularBrokerClient::serverName() const
+{
+    return m_serverName;
+}
+
+void TimeularBrokerClient::setServerName(const QString &name)
+{
+    if (name != m_serverName) {
+        m_serverName = name;
+        emit serverNameChanged(m_serverName);
+    }
+}
+
+bool TimeularBrokerClient::isAttached() const
+{
+    return m_attached;
+}
+
+int TimeularBrokerClient::status() const
+{
+    return m_status;
+}
+
+int TimeularBrokerClient::orientation() const
+{
+    return m_orientation;
+}
+
+int TimeularBrokerClient::stableOrientation() const
+{
+    return m_stableOrientation;
+}
+
+quint64 TimeularBrokerClient::deviceId() const
+{
+    return m_deviceId;
+}
+
+void TimeularBrokerClient::connectToBroker()
+{
+    m_wanted = true;
+    if (m_socket->state() != QLocalSocket::UnconnectedState)
+        return;
+
+    // only retried when asked to again
+    m_incompatible = false;
+
+    m_buffer.clear();
+    m_socket->connectToServer(m_serverName);
+}
+
+void TimeularBrokerClient::disconnectFromBroker()
+{
+    m_wanted = false;
+    m_retryTimer->stop();
+    m_socket->abort();
+    setAttached(false);
+}
+
+void TimeularBrokerClient::socketDisconnected()
+{
+    setAttached(false);
+    // the broker may just be restarting, an incompatible one won't change
+    if (m_wanted && !m_incompatible && !m_retryTimer->isActive())
+        m_retryTimer->start();
+}
+
+void TimeularBrokerClient::setAttached(bool attached)
+{
+    if (attached != m_attached) {
+        m_attached = attached;
+        emit attachedChanged(m_attached);
+    }
+}
+
+void TimeularBrokerClient::readFrames()
+{
+    m_buffer.append(m_socket->readAll());
+
+    int offset = 0;
+    while (offset < m_buffer.size()) {
+        const uchar *frame = reinterpret_cast<const uchar *>(m_buffer.constData()) + offset;
+        const int size = BrokerProtocol::frameSize(frame[0]);
+        if (size == 0) {
+            qWarning() << "Broker sent an unknown frame" << frame[0];
+            m_buffer.clear();
+            m_socket->abort();
+            return;
+        }
+        if (m_buffer.size() - offset < size)
+            break;
+
+        if (!handleFrame(frame)) {
+            // nothing after a bad frame can be trusted
+            m_buffer.clear();
+            m_socket->abort();
+            return;
+        }
+        offset += size;
+    }
+    m_buffer.remove(0, offset);
+}
+
+bool TimeularBrokerClient::handleFrame(const uchar *frame)
+{
+    if (!m_attached && frame[0] != BrokerProtocol::Hello) {
+        qWarning() << "Broker didn't say hello";
+        return false;
+    }
+
+    switch (frame[0]) {
+    case BrokerProtocol::Hello:
+        if (!BrokerProtocol::validHello(frame)) {
+            qWarning() << "Incompatible broker" << m_serverName << "not reconnecting";
+            m_incompatible = true;
+            return false;
+        }
+        setAttached(true);
+        break;
+    case BrokerProtocol::Status: {
+        m_deviceId = qFromLittleEndian<quint64>(frame + 1);
+        if (frame[9] != m_status) {
+            m_status = frame[9];
+            emit statusChanged(m_status);
+        }
+        break;
+    }
+    case BrokerProtocol::Orientation: {
+        const OrientationEvent event = BrokerProtocol::decodeEvent(frame);
+        if (event.face != m_orientation) {
+            m_orientation = event.face;
+            emit orientationChanged(m_orientation);
+        }
+        break;
+    }
+    case BrokerProtocol::StableOrientation: {
+        const OrientationEvent event = BrokerProtocol::decodeEvent(frame);
+        if (event.face != m_stableOrientation) {
+            m_stableOrientation = event.face;
+            emit stableOrientationChanged(m_stableOrientation, event.timestamp);
+        }
+        break;
+    }
+    }
+    return true;
+}
@@ -0,0 +1,98 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef TIMEULARBROKERCLIENT_H
+#define TIMEULARBROKERCLIENT_H
+
+#include <QObject>
+#include <QByteArray>
+
+#include "orientationevent.h"
+
+class QLocalSocket;
+class QTimer;
+
+// Follows a die through a TimeularBroker in another process instead of
+// connecting to it. Reconnects on its own when the broker restarts, unless
+// it turned out to speak another protocol version.
+class TimeularBrokerClient : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QString serverName READ serverName WRITE setServerName NOTIFY serverNameChanged)
+    Q_PROPERTY(bool attached READ isAttached NOTIFY attachedChanged)
+    Q_PROPERTY(int status READ status NOTIFY statusChanged)
+    Q_PROPERTY(int orientation READ orientation NOTIFY orientationChanged)
+    Q_PROPERTY(int stableOrientation READ stableOrientation NOTIFY stableOrientationChanged)
+public:
+    explicit TimeularBrokerClient(QObject *parent = nullptr);
+
+    QString serverName() const;
+    void setServerName(const QString &name);
+
+    // connected to a broker that said hello
+    bool isAttached() const;
+    // TimeularManager::Status and Orientation values
+    int status() const;
+    int orientation() const;
+    int stableOrientation() const;
+    quint64 deviceId() const;
+
+public slots:
+    void connectToBroker();
+    void disconnectFromBroker();
+
+signals:
+    void serverNameChanged(const QString &name);
+    void attachedChanged(bool attached);
+    void statusChanged(int status);
+    void orientationChanged(int orientation);
+    // timestamp in msecs since epoch, when the face was first seen
+    void stableOrientationChanged(int orientation, qint64 timestamp);
+
+private:
+    void readFrames();
+    // false when the stream can't be trusted any further
+    bool handleFrame(const uchar *frame);
+    void setAttached(bool attached);
+    void socketDisconnected();
+
+    QLocalSocket *m_socket = nullptr;
+    QTimer *m_retryTimer = nullptr;
+    QString m_serverName;
+    QByteArray m_buffer;
+    bool m_wanted = false;
+    bool m_attached = false;
+    bool m_incompatible = false;
+    int m_status = 0;
+    int m_orientation = 0;
+    int m_stableOrientation = 0;
+    quint64 m_deviceId = 0;
+};
+
+#endif // TIMEULARBROKERCLIENT_H
@@ -0,0 +1,318 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "timeulardevice.h"
+#include "bletransport.h"
+#include "devicecache.h"
+#include "eventring.h"
+#include "linksupervisor.h"
+#include "metrics.h"
+#include "startuptrace.h"
+#include "timeularstats.h"
+
+#include <QDateTime>
+#include <QDebug>
+
+TimeularDevice::TimeularDevice(const QBluetoothDeviceInfo &info, DeviceCache *cache, QObject *parent)
+    : TimeularDevice(info, new BleTransport(info, cache), parent)
+{
+}
+
+TimeularDevice::TimeularDevice(const QBluetoothDeviceInfo &info, TimeularTransport *transport, QObject *parent)
+    : QObject(parent)
+    , m_info(info)
+    , m_transport(transport)
+    , m_rssi(info.rssi())
+{
+    m_transport->setParent(this);
+    m_linkProfile = new LinkProfile(this);
+    m_supervisor = new LinkSupervisor(this);
+    connect(m_linkProfile, &LinkProfile::profileChanged,
+            this, [this]() {
+                if (m_status == Connected)
+                    m_transport->requestConnectionParameters(m_linkProfile->parameters());
+            });
+
+    connect(m_transport, &TimeularTransport::connected,
+            this, [this]() { mark(TimeularStats::LinkConnected, m_connectStarted); });
+    connect(m_transport, &TimeularTransport::serviceDiscovered,
+            this, [this]() { mark(TimeularStats::ServiceDiscovered, m_connectStarted); });
+    connect(m_transport, &TimeularTransport::detailsDiscovered,
+            this, [this]() { mark(TimeularStats::DetailsDiscovered, m_connectStarted); });
+    connect(m_transport, &TimeularTransport::subscribed,
+            this, &TimeularDevice::transportSubscribed);
+    connect(m_transport, &TimeularTransport::notificationsEnabled,
+            this, [this]() {
+                mark(TimeularStats::NotificationsEnabled, m_connectStarted);
+                // negotiate once the subscription is in place so it doesn't slow down the setup
+                m_linkProfile->reset();
+                m_transport->requestConnectionParameters(m_linkProfile->parameters());
+            });
+    connect(m_transport, &TimeularTransport::disconnected,
+            this, [this]() {
+                if (m_status == Connected && !m_disconnecting) {
+                    Metrics::add(Metrics::LinksLost);
+                    emit linkLost();
+                } else if (m_status == Connecting && !m_disconnecting) {
+                    Metrics::add(Metrics::ConnectFailures);
+                }
+                setStatus(Disconnected);
+            });
+    connect(m_transport, &TimeularTransport::notificationReceived,
+            this, &TimeularDevice::notificationReceived);
+    connect(m_transport, &TimeularTransport::orientationRead,
+            this, &TimeularDevice::orientationRead);
+    connect(m_transport, &TimeularTransport::connectionParametersChanged,
+            this, &TimeularDevice::transportParametersChanged);
+    connect(m_transport, &TimeularTransport::batteryRead,
+            this, &TimeularDevice::batteryRead);
+}
+
+TimeularDevice::~TimeularDevice()
+{
+}
+
+QBluetoothDeviceInfo TimeularDevice::deviceInfo() const
+{
+    return m_info;
+}
+
+QString TimeularDevice::key() const
+{
+    return DeviceCache::deviceKey(m_info.address(), m_info.deviceUuid());
+}
+
+quint64 TimeularDevice::deviceId(const QBluetoothDeviceInfo &info)
+{
+    if (!info.address().isNull())
+        return info.address().toUInt64();
+
+    // no address on Apple platforms, fold the per-host uuid into 48 bits instead
+    const QBluetoothUuid uuid = info.deviceUuid();
+    return (quint64(uuid.data1) << 16) | uuid.data2;
+}
+
+quint64 TimeularDevice::deviceId() const
+{
+    return deviceId(m_info);
+}
+
+TimeularDevice::Status TimeularDevice::status() const
+{
+    return m_status;
+}
+
+int TimeularDevice::orientation() const
+{
+    return m_orientation;
+}
+
+TimeularTransport *TimeularDevice::transport() const
+{
+    return m_transport;
+}
+
+LinkProfile *TimeularDevice::linkProfile() const
+{
+    return m_linkProfile;
+}
+
+LinkSupervisor *TimeularDevice::supervisor() const
+{
+    return m_supervisor;
+}
+
+QLowEnergyConnectionParameters TimeularDevice::connectionParameters() const
+{
+    return m_connectionParameters;
+}
+
+int TimeularDevice::batteryLevel() const
+{
+    return m_batteryLevel;
+}
+
+qint16 TimeularDevice::rssi() const
+{
+    return m_rssi;
+}
+
+void TimeularDevice::setRssi(qint16 rssi)
+{
+    if (rssi != m_rssi) {
+        m_rssi = rssi;
+        emit rssiChanged(m_rssi);
+    }
+}
+
+qint64 TimeularDevice::msecsSinceActivity() const
+{
+    return m_activity.isValid() ? m_activity.elapsed() : 0;
+}
+
+void TimeularDevice::setStats(TimeularStats *stats)
+{
+    m_stats = stats;
+}
+
+void TimeularDevice::setEventRing(EventRing *ring)
+{
+    m_eventRing = ring;
+}
+
+void TimeularDevice::mark(TimeularStats::Phase phase, qint64 since)
+{
+    if (m_stats && m_stats->isMeasuring())
+        m_stats->record(phase, since);
+}
+
+void TimeularDevice::setStatus(Status status)
+{
+    if (status != m_status) {
+        m_status = status;
+        emit statusChanged(m_status);
+    }
+}
+
+void TimeularDevice::connectToDevice()
+{
+    if (m_status != Disconnected)
+        return;
+
+    if (m_stats)
+        m_connectStarted = m_stats->timestamp();
+    m_firstNotification = true;
+    m_firstOrientation = true;
+    Metrics::add(Metrics::ConnectAttempts);
+    setStatus(Connecting);
+    m_transport->connectToDevice();
+}
+
+void TimeularDevice::disconnectFromDevice()
+{
+    if (m_status == Disconnected)
+        return;
+
+    m_disconnecting = true;
+    m_transport->disconnectFromDevice();
+    m_disconnecting = false;
+    setStatus(Disconnected);
+}
+
+void TimeularDevice::readOrientation()
+{
+    if (m_status == Connected)
+        m_transport->readOrientation();
+}
+
+void TimeularDevice::readBattery()
+{
+    if (m_status == Connected)
+        m_transport->readBattery();
+}
+
+void TimeularDevice::transportSubscribed(QLowEnergyHandle orientationHandle)
+{
+    m_decoder.setOrientationHandle(orientationHandle);
+    m_activity.start();
+    Metrics::add(Metrics::Connects);
+    setStatus(Connected);
+}
+
+void TimeularDevice::transportParametersChanged(const QLowEnergyConnectionParameters &parameters)
+{
+    qDebug() << "Connection parameters" << key() << "interval" << parameters.minimumInterval()
+             << "latency" << parameters.latency() << "timeout" << parameters.supervisionTimeout();
+    m_connectionParameters = parameters;
+    emit connectionParametersChanged(m_connectionParameters);
+}
+
+void TimeularDevice::notificationReceived(QLowEnergyHandle handle, const QByteArray &value)
+{
+    m_activity.start();
+    Metrics::add(Metrics::Notifications);
+    const int orientation = m_decoder.decode(handle, value);
+    if (orientation < 0)
+        return;
+
+    if (m_firstNotification) {
+        m_firstNotification = false;
+        mark(TimeularStats::FirstNotification, m_connectStarted);
+    }
+    updateOrientation(orientation);
+}
+
+void TimeularDevice::orientationRead(QLowEnergyHandle handle, const QByteArray &value)
+{
+    m_activity.start();
+    const int orientation = m_decoder.decode(handle, value);
+    if (orientation >= 0)
+        updateOrientation(orientation);
+}
+
+void TimeularDevice::updateOrientation(int orientation)
+{
+    const bool measure = m_stats && m_stats->isMeasuring();
+    if (m_firstOrientation) {
+        m_firstOrientation = false;
+        StartupTrace::mark(StartupTrace::FirstOrientation);
+        if (measure)
+            m_stats->record(TimeularStats::FirstOrientation, m_connectStarted);
+    }
+
+    if (orientation != m_orientation) {
+        m_orientation = orientation;
+        Metrics::add(Metrics::OrientationChanges);
+        m_linkProfile->addEvent();
+        const qint64 received = measure ? m_stats->timestamp() : 0;
+        if (m_eventRing) {
+            OrientationEvent event;
+            event.timestamp = QDateTime::currentMSecsSinceEpoch();
+            event.deviceId = deviceId();
+            event.face = quint8(orientation);
+            m_eventRing->publish(event);
+        }
+        emit orientationChanged(m_orientation);
+        if (measure)
+            m_stats->record(TimeularStats::OrientationDelivered, received);
+    }
+}
+
+void TimeularDevice::batteryRead(int level)
+{
+    if (level < 0 || level > 100)
+        return;
+
+    Metrics::add(Metrics::BatteryReads);
+    if (level != m_batteryLevel) {
+        m_batteryLevel = level;
+        qDebug() << "Battery" << key() << level << "%";
+        emit batteryLevelChanged(m_batteryLevel);
+    }
+}
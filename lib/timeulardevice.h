@@ -0,0 +1,135 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef TIMEULARDEVICE_H
+#define TIMEULARDEVICE_H
+
+#include <QObject>
+#include <QBluetoothDeviceInfo>
+#include <QElapsedTimer>
+#include <QLowEnergyConnectionParameters>
+
+#include "linkprofile.h"
+
+#include "timeularstats.h"
+#include "zeidecoder.h"
+
+class DeviceCache;
+class EventRing;
+class LinkSupervisor;
+class TimeularTransport;
+
+class TimeularDevice : public QObject
+{
+    Q_OBJECT
+public:
+    enum Status {
+        Disconnected,
+        Connecting,
+        Connected,
+    };
+    Q_ENUM(Status)
+
+    TimeularDevice(const QBluetoothDeviceInfo &info, DeviceCache *cache, QObject *parent = nullptr);
+    TimeularDevice(const QBluetoothDeviceInfo &info, TimeularTransport *transport, QObject *parent = nullptr);
+    ~TimeularDevice();
+
+    template <typename Profile>
+    static bool matches(const QBluetoothDeviceInfo &info)
+    {
+        return (info.coreConfigurations() & QBluetoothDeviceInfo::LowEnergyCoreConfiguration)
+            && Profile::matchesName(info.name());
+    }
+    static bool isTimeularDevice(const QBluetoothDeviceInfo &info) { return matches<ZeiProfile>(info); }
+    static quint64 deviceId(const QBluetoothDeviceInfo &info);
+
+    QBluetoothDeviceInfo deviceInfo() const;
+    QString key() const;
+    quint64 deviceId() const;
+    Status status() const;
+    int orientation() const;
+    TimeularTransport *transport() const;
+    LinkProfile *linkProfile() const;
+    LinkSupervisor *supervisor() const;
+    QLowEnergyConnectionParameters connectionParameters() const;
+    // percent, -1 until it was read once, kept across links
+    int batteryLevel() const;
+    // dBm of the last advertisement, dice don't advertise while connected
+    qint16 rssi() const;
+    void setRssi(qint16 rssi);
+    // since the last notification, read or subscription on this link
+    qint64 msecsSinceActivity() const;
+
+    void setStats(TimeularStats *stats);
+    void setEventRing(EventRing *ring);
+
+    void connectToDevice();
+    void disconnectFromDevice();
+    void readOrientation();
+    void readBattery();
+
+signals:
+    void statusChanged(Status status);
+    // an established link dropped without being asked to, sent before statusChanged()
+    void linkLost();
+    void orientationChanged(int orientation);
+    void connectionParametersChanged(const QLowEnergyConnectionParameters &parameters);
+    void batteryLevelChanged(int level);
+    void rssiChanged(qint16 rssi);
+
+private:
+    void setStatus(Status status);
+    void mark(TimeularStats::Phase phase, qint64 since);
+    void transportSubscribed(QLowEnergyHandle orientationHandle);
+    void transportParametersChanged(const QLowEnergyConnectionParameters &parameters);
+    void notificationReceived(QLowEnergyHandle handle, const QByteArray &value);
+    void orientationRead(QLowEnergyHandle handle, const QByteArray &value);
+    void updateOrientation(int orientation);
+    void batteryRead(int level);
+
+    QBluetoothDeviceInfo m_info;
+    TimeularTransport *m_transport;
+    LinkProfile *m_linkProfile = nullptr;
+    LinkSupervisor *m_supervisor = nullptr;
+    QLowEnergyConnectionParameters m_connectionParameters;
+    Status m_status = Disconnected;
+    ZeiDecoder m_decoder;
+    int m_orientation = 0;
+    int m_batteryLevel = -1;
+    qint16 m_rssi = 0;
+    QElapsedTimer m_activity;
+    TimeularStats *m_stats = nullptr;
+    EventRing *m_eventRing = nullptr;
+    qint64 m_connectStarted = 0;
+    bool m_firstNotification = false;
+    bool m_firstOrientation = false;
+    bool m_disconnecting = false;
+};
+
+#endif // TIMEULARDEVICE_H
@@ -0,0 +1,466 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "timeularmanager.h"
+#include "linksupervisor.h"
+#include "sessionsnapshot.h"
+#include "startuptrace.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QSignalBlocker>
+#include <QTimer>
+
+namespace {
+    // a ZEI that is awake answers within a second, don't wait for a full scan
+    const int directConnectTimeout = 3000;
+    // bounds how much of the log a restart has to replay
+    const int snapshotInterval = 60000;
+}
+
+TimeularManager::TimeularManager(QObject *parent)
+    : QObject(parent)
+{
+    m_stats = new TimeularStats(this);
+    m_sessionLog = new SessionLogWriter(this);
+    m_aggregator = new FaceAggregator(this);
+    m_telemetry = new TelemetryScheduler(this);
+
+    m_filter = new OrientationFilter(this);
+    connect(m_filter, &OrientationFilter::stableOrientationChanged,
+            this, &TimeularManager::orientationSettled);
+    connect(m_filter, &OrientationFilter::suppressedCountChanged,
+            this, &TimeularManager::suppressedChangesChanged);
+
+    // the discovery agent is only created once it's needed, reconnecting to
+    // a known die doesn't scan at all
+
+    m_snapshotTimer = new QTimer(this);
+    m_snapshotTimer->setSingleShot(true);
+    m_snapshotTimer->setInterval(snapshotInterval);
+    connect(m_snapshotTimer, &QTimer::timeout,
+            this, &TimeularManager::writeSnapshot);
+
+    m_connectTimer = new QTimer(this);
+    m_connectTimer->setSingleShot(true);
+    m_connectTimer->setInterval(directConnectTimeout);
+    connect(m_connectTimer, &QTimer::timeout,
+            this, &TimeularManager::directConnectFailed);
+}
+
+TimeularManager::~TimeularManager()
+{
+    writeSnapshot();
+}
+
+TimeularManager::Orientation TimeularManager::orientation() const
+{
+    return m_orientation;
+}
+
+TimeularManager::Orientation TimeularManager::stableOrientation() const
+{
+    return m_stableOrientation;
+}
+
+qint64 TimeularManager::stableSince() const
+{
+    return m_stableSince;
+}
+
+quint64 TimeularManager::deviceId() const
+{
+    return m_device ? m_device->deviceId() : 0;
+}
+
+int TimeularManager::settleTime() const
+{
+    return m_filter->settleTime();
+}
+
+void TimeularManager::setSettleTime(int msecs)
+{
+    if (msecs == m_filter->settleTime())
+        return;
+
+    m_filter->setSettleTime(msecs);
+    emit settleTimeChanged(m_filter->settleTime());
+}
+
+quint64 TimeularManager::suppressedChanges() const
+{
+    return m_filter->suppressedCount();
+}
+
+TimeularStats *TimeularManager::stats() const
+{
+    return m_stats;
+}
+
+ScanScheduler *TimeularManager::scanScheduler()
+{
+    if (!m_scanScheduler) {
+        m_deviceDiscoveryAgent = new QBluetoothDeviceDiscoveryAgent(this);
+        m_scanScheduler = new ScanScheduler(m_deviceDiscoveryAgent, this);
+        connect(m_deviceDiscoveryAgent, &QBluetoothDeviceDiscoveryAgent::deviceDiscovered,
+                this, &TimeularManager::deviceDiscovered);
+        connect(m_deviceDiscoveryAgent, &QBluetoothDeviceDiscoveryAgent::deviceUpdated,
+                this, &TimeularManager::deviceUpdated);
+    }
+    return m_scanScheduler;
+}
+
+EventRing *TimeularManager::eventRing()
+{
+    return &m_eventRing;
+}
+
+FaceAggregator *TimeularManager::aggregator() const
+{
+    return m_aggregator;
+}
+
+TelemetryScheduler *TimeularManager::telemetry() const
+{
+    return m_telemetry;
+}
+
+QString TimeularManager::sessionLog() const
+{
+    return m_sessionLog->isOpen() ? m_sessionLog->fileName() : QString();
+}
+
+void TimeularManager::setSessionLog(const QString &fileName)
+{
+    if (fileName == sessionLog())
+        return;
+
+    writeSnapshot();
+    m_aggregator->clear();
+    if (fileName.isEmpty()) {
+        m_sessionLog->close();
+    } else {
+        SessionLogReader history;
+        if (history.open(fileName)) {
+            // only the tail after the last snapshot has to be replayed
+            const qint64 restored = SessionSnapshot::read(fileName, history, m_aggregator);
+            m_aggregator->load(history, qMax<qint64>(0, restored));
+            qDebug() << "Replayed" << history.count() - qMax<qint64>(0, restored)
+                     << "of" << history.count() << "session log records";
+        }
+        m_sessionLog->open(fileName);
+        restoreStableOrientation();
+    }
+    emit sessionLogChanged(sessionLog());
+}
+
+TimeularManager::Status TimeularManager::status() const
+{
+    return m_status;
+}
+
+TimeularState TimeularManager::state() const
+{
+    TimeularState state;
+    state.status = m_status;
+    state.orientation = m_orientation;
+    state.stableOrientation = m_stableOrientation;
+    return state;
+}
+
+LinkProfile::Profile TimeularManager::linkProfile() const
+{
+    return m_device ? m_device->linkProfile()->profile() : LinkProfile::Interactive;
+}
+
+qreal TimeularManager::connectionInterval() const
+{
+    // negotiated parameters come back with min == max
+    return m_device ? m_device->connectionParameters().minimumInterval() : 0;
+}
+
+int TimeularManager::connectionLatency() const
+{
+    return m_device ? m_device->connectionParameters().latency() : 0;
+}
+
+int TimeularManager::supervisionTimeout() const
+{
+    return m_device ? m_device->connectionParameters().supervisionTimeout() : 0;
+}
+
+int TimeularManager::linkGaps() const
+{
+    return m_device ? m_device->supervisor()->gapCount() : 0;
+}
+
+qint64 TimeularManager::lastLinkGap() const
+{
+    return m_device ? m_device->supervisor()->lastGap() : 0;
+}
+
+int TimeularManager::batteryLevel() const
+{
+    return m_device ? m_device->batteryLevel() : -1;
+}
+
+int TimeularManager::rssi() const
+{
+    return m_device ? m_device->rssi() : 0;
+}
+
+void TimeularManager::setStatus(Status status)
+{
+    if (status != m_status) {
+        m_status = status;
+        emit statusChanged(m_status);
+        emit stateChanged();
+    }
+}
+
+void TimeularManager::startDiscovery()
+{
+    if (m_status != Disconneted)
+        return;
+
+    setStatus(Connecting);
+    StartupTrace::mark(StartupTrace::DiscoveryStarted);
+
+    const DeviceCache::Entry cached = m_cache.lastDevice();
+    if (cached.isValid()) {
+        qDebug() << "Connecting to known device";
+        m_directConnect = true;
+        connectToDevice(cached.deviceInfo());
+        m_connectTimer->start();
+    } else {
+        startScan();
+    }
+}
+
+void TimeularManager::startScan()
+{
+    qDebug() << "Starting Discovery";
+    m_directConnect = false;
+    m_scanStarted = m_stats->timestamp();
+    scanScheduler()->start();
+}
+
+void TimeularManager::connectToDevice(const QBluetoothDeviceInfo &info)
+{
+    if (m_device && m_device->key() != DeviceCache::deviceKey(info.address(), info.deviceUuid())) {
+        m_device->disconnect(this);
+        m_device->disconnectFromDevice();
+        m_device->deleteLater();
+        m_device = nullptr;
+    }
+
+    if (!m_device) {
+        m_device = new TimeularDevice(info, &m_cache, this);
+        m_device->setStats(m_stats);
+        m_device->setEventRing(&m_eventRing);
+        connect(m_device, &TimeularDevice::statusChanged,
+                this, &TimeularManager::deviceStatusChanged);
+        connect(m_device, &TimeularDevice::orientationChanged,
+                this, &TimeularManager::deviceOrientationChanged);
+        connect(m_device->linkProfile(), &LinkProfile::profileChanged,
+                this, &TimeularManager::linkProfileChanged);
+        connect(m_device, &TimeularDevice::connectionParametersChanged,
+                this, &TimeularManager::connectionParametersChanged);
+        connect(m_device->supervisor(), &LinkSupervisor::linkRestored,
+                this, &TimeularManager::linkRestored);
+        connect(m_device->supervisor(), &LinkSupervisor::recoveryFailed,
+                this, &TimeularManager::recoveryFailed);
+        connect(m_device, &TimeularDevice::batteryLevelChanged,
+                this, &TimeularManager::telemetryChanged);
+        connect(m_device, &TimeularDevice::rssiChanged,
+                this, &TimeularManager::telemetryChanged);
+        m_telemetry->addDevice(m_device);
+        emit telemetryChanged();
+    }
+
+    m_device->connectToDevice();
+}
+
+void TimeularManager::directConnectFailed()
+{
+    if (!m_directConnect)
+        return;
+
+    qDebug() << "Known device not reachable, falling back to discovery";
+    m_connectTimer->stop();
+    m_directConnect = false;
+    {
+        // keep the device and its controller around, the scan most likely finds the same die
+        const QSignalBlocker blocker(m_device);
+        m_device->disconnectFromDevice();
+    }
+    startScan();
+}
+
+void TimeularManager::deviceDiscovered(const QBluetoothDeviceInfo &info)
+{
+    deviceUpdated(info);
+    if (m_status != Connecting || m_directConnect)
+        return;
+
+    if (TimeularDevice::isTimeularDevice(info)) {
+        qDebug() << "Connecting to device";
+        if (m_stats->isMeasuring())
+            m_stats->record(TimeularStats::DeviceFound, m_scanStarted);
+        // scanning competes with the connection attempt for radio time
+        m_scanScheduler->stop();
+        connectToDevice(info);
+    }
+}
+
+void TimeularManager::deviceUpdated(const QBluetoothDeviceInfo &info)
+{
+    // the only rssi there is, Qt can't read it from an established link
+    if (m_device && info.rssi() != 0 && TimeularDevice::deviceId(info) == m_device->deviceId())
+        m_device->setRssi(info.rssi());
+}
+
+void TimeularManager::deviceStatusChanged(TimeularDevice::Status status)
+{
+    switch (status) {
+    case TimeularDevice::Connecting:
+        break;
+    case TimeularDevice::Connected:
+        m_connectTimer->stop();
+        m_directConnect = false;
+        StartupTrace::mark(StartupTrace::Connected);
+        setStatus(Connected);
+        break;
+    case TimeularDevice::Disconnected:
+        if (m_directConnect) {
+            directConnectFailed();
+        } else if (m_device && m_device->supervisor()->isRecovering()) {
+            setStatus(Connecting);
+        } else if (m_status == Connected) {
+            recoveryFailed();
+        } else {
+            setStatus(Disconneted);
+        }
+        break;
+    }
+}
+
+void TimeularManager::recoveryFailed()
+{
+    // the die is most likely still close by, look for it hard for a while
+    setStatus(Disconneted);
+    scanScheduler()->boost();
+    startDiscovery();
+}
+
+void TimeularManager::deviceOrientationChanged(int orientation)
+{
+    if (orientation != m_orientation) {
+        m_orientation = static_cast<Orientation>(orientation);
+        emit orientationChanged(m_orientation);
+        emit stateChanged();
+        m_filter->addSample(orientation, QDateTime::currentMSecsSinceEpoch());
+    }
+}
+
+void TimeularManager::orientationSettled(int orientation, qint64 timestamp)
+{
+    m_stableOrientation = static_cast<Orientation>(orientation);
+    m_stableSince = timestamp;
+
+    OrientationEvent event;
+    event.timestamp = timestamp;
+    event.deviceId = deviceId();
+    event.face = quint8(orientation);
+    m_sessionLog->append(event);
+    m_aggregator->addEvent(event);
+    if (m_sessionLog->isOpen() && !m_snapshotTimer->isActive())
+        m_snapshotTimer->start();
+
+    emit stableOrientationChanged(m_stableOrientation);
+    emit stateChanged();
+}
+
+void TimeularManager::restoreStableOrientation()
+{
+    // carry on with the interval that was in progress when we last stopped,
+    // unless the die is already reporting, its own samples win then
+    const OrientationEvent last = m_aggregator->lastEvent();
+    if (last.timestamp == 0 || m_stableSince != 0 || m_status == Connected)
+        return;
+
+    m_stableOrientation = static_cast<Orientation>(qMin<int>(last.face, Face8));
+    m_stableSince = last.timestamp;
+    m_filter->reset(m_stableOrientation);
+    emit stableOrientationChanged(m_stableOrientation);
+    emit stateChanged();
+}
+
+void TimeularManager::writeSnapshot()
+{
+    m_snapshotTimer->stop();
+    if (!m_sessionLog->isOpen())
+        return;
+
+    // the snapshot may only cover records that are on disk
+    m_sessionLog->flush();
+    SessionSnapshot::write(m_sessionLog->fileName(), m_sessionLog->count(),
+                           m_sessionLog->lastTimestamp(), *m_aggregator);
+}
+
+QString TimeularState::statusText(int status)
+{
+    static const QString texts[] = {
+        QStringLiteral("Disconnected"),
+        QStringLiteral("Connecting"),
+        QStringLiteral("Connected")
+    };
+    if (status < 0 || status > TimeularManager::Connected)
+        return texts[TimeularManager::Disconneted];
+    return texts[status];
+}
+
+QString TimeularState::orientationText(int orientation)
+{
+    static const QString texts[] = {
+        QStringLiteral("Vertical"),
+        QStringLiteral("1"), QStringLiteral("2"), QStringLiteral("3"), QStringLiteral("4"),
+        QStringLiteral("5"), QStringLiteral("6"), QStringLiteral("7"), QStringLiteral("8")
+    };
+    if (orientation < 0 || orientation > TimeularManager::Face8)
+        return texts[TimeularManager::Vertical];
+    return texts[orientation];
+}
+
+bool TimeularState::operator==(const TimeularState &other) const
+{
+    return status == other.status
+        && orientation == other.orientation
+        && stableOrientation == other.stableOrientation;
+}
@@ -0,0 +1,207 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef TIMEULARMANAGER_H
+#define TIMEULARMANAGER_H
+
+#include <QObject>
+#include <QBluetoothDeviceDiscoveryAgent>
+
+#include "devicecache.h"
+#include "eventring.h"
+#include "faceaggregator.h"
+#include "linkprofile.h"
+#include "orientationfilter.h"
+#include "scanscheduler.h"
+#include "sessionlog.h"
+#include "telemetryscheduler.h"
+#include "timeulardevice.h"
+#include "timeularstats.h"
+
+class QTimer;
+class TimeularState;
+
+class TimeularManager : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(Status status READ status NOTIFY statusChanged)
+    Q_PROPERTY(Orientation orientation READ orientation NOTIFY orientationChanged)
+    Q_PROPERTY(Orientation stableOrientation READ stableOrientation NOTIFY stableOrientationChanged)
+    Q_PROPERTY(TimeularState state READ state NOTIFY stateChanged)
+    Q_PROPERTY(LinkProfile::Profile linkProfile READ linkProfile NOTIFY linkProfileChanged)
+    Q_PROPERTY(qreal connectionInterval READ connectionInterval NOTIFY connectionParametersChanged)
+    Q_PROPERTY(int connectionLatency READ connectionLatency NOTIFY connectionParametersChanged)
+    Q_PROPERTY(int supervisionTimeout READ supervisionTimeout NOTIFY connectionParametersChanged)
+    Q_PROPERTY(int linkGaps READ linkGaps NOTIFY linkRestored)
+    Q_PROPERTY(qint64 lastLinkGap READ lastLinkGap NOTIFY linkRestored)
+    Q_PROPERTY(int batteryLevel READ batteryLevel NOTIFY telemetryChanged)
+    Q_PROPERTY(int rssi READ rssi NOTIFY telemetryChanged)
+    Q_PROPERTY(int settleTime READ settleTime WRITE setSettleTime NOTIFY settleTimeChanged)
+    Q_PROPERTY(quint64 suppressedChanges READ suppressedChanges NOTIFY suppressedChangesChanged)
+    Q_PROPERTY(TimeularStats *stats READ stats CONSTANT)
+    Q_PROPERTY(ScanScheduler *scanScheduler READ scanScheduler CONSTANT)
+    Q_PROPERTY(FaceAggregator *aggregator READ aggregator CONSTANT)
+    Q_PROPERTY(TelemetryScheduler *telemetry READ telemetry CONSTANT)
+    Q_PROPERTY(QString sessionLog READ sessionLog WRITE setSessionLog NOTIFY sessionLogChanged)
+public:
+    enum Status {
+        Disconneted,
+        Connecting,
+        Connected,
+    };
+    Q_ENUM(Status)
+
+    enum Orientation {
+        Vertical,
+        Face1,
+        Face2,
+        Face3,
+        Face4,
+        Face5,
+        Face6,
+        Face7,
+        Face8
+    };
+    Q_ENUM(Orientation)
+
+    explicit TimeularManager(QObject *parent = nullptr);
+    ~TimeularManager();
+
+    Status status() const;
+    Orientation orientation() const;
+    Orientation stableOrientation() const;
+    // msecs since epoch at which the stable orientation was first seen
+    qint64 stableSince() const;
+    // of the current die, 0 while there is none
+    quint64 deviceId() const;
+    TimeularState state() const;
+    LinkProfile::Profile linkProfile() const;
+    qreal connectionInterval() const;
+    int connectionLatency() const;
+    int supervisionTimeout() const;
+    int linkGaps() const;
+    qint64 lastLinkGap() const;
+    // percent, -1 while unknown
+    int batteryLevel() const;
+    // dBm of the last advertisement, 0 while unknown
+    int rssi() const;
+    int settleTime() const;
+    void setSettleTime(int msecs);
+    quint64 suppressedChanges() const;
+    TimeularStats *stats() const;
+    ScanScheduler *scanScheduler();
+    EventRing *eventRing();
+    FaceAggregator *aggregator() const;
+    TelemetryScheduler *telemetry() const;
+    QString sessionLog() const;
+    void setSessionLog(const QString &fileName);
+
+public slots:
+    void startDiscovery();
+
+signals:
+    void statusChanged(Status status);
+    void orientationChanged(Orientation orientation);
+    void stableOrientationChanged(Orientation orientation);
+    void stateChanged();
+    void linkProfileChanged(LinkProfile::Profile profile);
+    void connectionParametersChanged();
+    // lostAt in msecs since epoch, gap in msecs
+    void linkRestored(qint64 lostAt, qint64 gap);
+    void telemetryChanged();
+    void settleTimeChanged(int msecs);
+    void suppressedChangesChanged(quint64 count);
+    void sessionLogChanged(const QString &fileName);
+
+private:
+    void setStatus(Status status);
+    void startScan();
+    void connectToDevice(const QBluetoothDeviceInfo &info);
+    void directConnectFailed();
+    void recoveryFailed();
+    void deviceDiscovered(const QBluetoothDeviceInfo &info);
+    void deviceUpdated(const QBluetoothDeviceInfo &info);
+    void deviceStatusChanged(TimeularDevice::Status status);
+    void deviceOrientationChanged(int orientation);
+    void orientationSettled(int orientation, qint64 timestamp);
+    void restoreStableOrientation();
+    void writeSnapshot();
+
+    Status m_status = Disconneted;
+    QBluetoothDeviceDiscoveryAgent *m_deviceDiscoveryAgent = nullptr;
+    ScanScheduler *m_scanScheduler = nullptr;
+    EventRing m_eventRing;
+    TimeularDevice *m_device = nullptr;
+    Orientation m_orientation = Vertical;
+    Orientation m_stableOrientation = Vertical;
+    qint64 m_stableSince = 0;
+    OrientationFilter *m_filter = nullptr;
+    DeviceCache m_cache;
+    QTimer *m_connectTimer = nullptr;
+    bool m_directConnect = false;
+    TimeularStats *m_stats = nullptr;
+    qint64 m_scanStarted = 0;
+    SessionLogWriter *m_sessionLog = nullptr;
+    QTimer *m_snapshotTimer = nullptr;
+    FaceAggregator *m_aggregator = nullptr;
+    TelemetryScheduler *m_telemetry = nullptr;
+};
+
+// typed snapshot of the manager state, display strings are looked up from
+// static tables so qml bindings don't need any script to format them
+class TimeularState
+{
+    Q_GADGET
+    Q_PROPERTY(TimeularManager::Status status MEMBER status)
+    Q_PROPERTY(TimeularManager::Orientation orientation MEMBER orientation)
+    Q_PROPERTY(TimeularManager::Orientation stableOrientation MEMBER stableOrientation)
+    Q_PROPERTY(bool connected READ isConnected)
+    Q_PROPERTY(QString statusText READ statusText)
+    Q_PROPERTY(QString orientationText READ orientationText)
+    Q_PROPERTY(QString stableOrientationText READ stableOrientationText)
+public:
+    TimeularManager::Status status = TimeularManager::Disconneted;
+    TimeularManager::Orientation orientation = TimeularManager::Vertical;
+    TimeularManager::Orientation stableOrientation = TimeularManager::Vertical;
+
+    bool isConnected() const { return status == TimeularManager::Connected; }
+    QString statusText() const { return statusText(status); }
+    QString orientationText() const { return orientationText(orientation); }
+    QString stableOrientationText() const { return orientationText(stableOrientation); }
+
+    static QString statusText(int status);
+    static QString orientationText(int orientation);
+
+    bool operator==(const TimeularState &other) const;
+    bool operator!=(const TimeularState &other) const { return !(*this == other); }
+};
+
+Q_DECLARE_METATYPE(TimeularState)
+
+#endif // TIMEULARMANAGER_H
@@ -0,0 +1,489 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "timeularpool.h"
+#include "linksupervisor.h"
+#include "startuptrace.h"
+#include "timeularmanager.h"
+
+#include <QDebug>
+#include <QTimer>
+
+TimeularPool::TimeularPool(QObject *parent)
+    : QAbstractListModel(parent)
+{
+    m_stats = new TimeularStats(this);
+    // keep scanning, dice that dropped out are picked up again when they advertise
+    m_adapters = new AdapterBalancer(this);
+    connect(m_adapters, &AdapterBalancer::deviceDiscovered,
+            this, &TimeularPool::deviceDiscovered);
+
+    m_presence = new PresenceTracker(this);
+    connect(m_adapters, &AdapterBalancer::deviceDiscovered,
+            m_presence, &PresenceTracker::sighted);
+    connect(m_adapters, &AdapterBalancer::deviceUpdated,
+            m_presence, &PresenceTracker::sighted);
+    connect(m_presence, &PresenceTracker::sightingUpdated,
+            this, &TimeularPool::devicePresenceChanged);
+    connect(m_presence, &PresenceTracker::presenceChanged,
+            this, &TimeularPool::devicePresenceChanged);
+
+    m_telemetry = new TelemetryScheduler(this);
+
+    m_updateTimer = new QTimer(this);
+    m_updateTimer->setSingleShot(true);
+    m_updateTimer->setTimerType(Qt::PreciseTimer);
+    m_updateTimer->setInterval(16);
+    connect(m_updateTimer, &QTimer::timeout,
+            this, &TimeularPool::flushChanges);
+}
+
+TimeularPool::~TimeularPool()
+{
+}
+
+int TimeularPool::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+        return 0;
+    return m_devices.size();
+}
+
+QVariant TimeularPool::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_devices.size())
+        return QVariant();
+
+    const TimeularDevice *device = m_devices.at(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+    case NameRole:
+        return device->deviceInfo().name();
+    case AddressRole:
+        return device->key();
+    case StatusRole:
+        return device->status();
+    case OrientationRole:
+        return device->orientation();
+    case StatusTextRole:
+        return TimeularState::statusText(device->status());
+    case OrientationTextRole:
+        return TimeularState::orientationText(device->orientation());
+    case ConnectedRole:
+        return device->status() == TimeularDevice::Connected;
+    case PresentRole:
+        return m_presence->isPresent(device->deviceId());
+    case RssiRole:
+        return m_presence->rssi(device->deviceId());
+    case LastSeenRole:
+        return m_presence->lastSeen(device->deviceId());
+    case PromotedRole:
+        return m_promoted.contains(device->key());
+    case BatteryRole:
+        return device->batteryLevel();
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> TimeularPool::roleNames() const
+{
+    return {
+        { AddressRole, "address" },
+        { NameRole, "name" },
+        { StatusRole, "status" },
+        { OrientationRole, "orientation" },
+        { StatusTextRole, "statusText" },
+        { OrientationTextRole, "orientationText" },
+        { ConnectedRole, "connected" },
+        { PresentRole, "present" },
+        { RssiRole, "rssi" },
+        { LastSeenRole, "lastSeen" },
+        { PromotedRole, "promoted" },
+        { BatteryRole, "battery" }
+    };
+}
+
+bool TimeularPool::isDiscovering() const
+{
+    return m_discovering;
+}
+
+int TimeularPool::maxPendingConnections() const
+{
+    return m_maxPendingConnections;
+}
+
+void TimeularPool::setMaxPendingConnections(int maxPendingConnections)
+{
+    maxPendingConnections = qMax(1, maxPendingConnections);
+    if (maxPendingConnections == m_maxPendingConnections)
+        return;
+
+    m_maxPendingConnections = maxPendingConnections;
+    emit maxPendingConnectionsChanged(m_maxPendingConnections);
+    connectPending();
+}
+
+int TimeularPool::connectedCount() const
+{
+    return m_connected.size();
+}
+
+int TimeularPool::updateInterval() const
+{
+    return m_updateTimer->interval();
+}
+
+void TimeularPool::setUpdateInterval(int msecs)
+{
+    msecs = qMax(0, msecs);
+    if (msecs == m_updateTimer->interval())
+        return;
+
+    m_updateTimer->setInterval(msecs);
+    if (msecs == 0)
+        flushChanges();
+    emit updateIntervalChanged(msecs);
+}
+
+TimeularStats *TimeularPool::stats() const
+{
+    return m_stats;
+}
+
+ScanScheduler *TimeularPool::scanScheduler() const
+{
+    return m_adapters->scheduler(0);
+}
+
+AdapterBalancer *TimeularPool::adapters() const
+{
+    return m_adapters;
+}
+
+PresenceTracker *TimeularPool::presence() const
+{
+    return m_presence;
+}
+
+TelemetryScheduler *TimeularPool::telemetry() const
+{
+    return m_telemetry;
+}
+
+bool TimeularPool::isPassive() const
+{
+    return m_passive;
+}
+
+void TimeularPool::setPassive(bool passive)
+{
+    if (passive == m_passive)
+        return;
+
+    m_passive = passive;
+    emit passiveChanged(m_passive);
+    for (TimeularDevice *device : qAsConst(m_devices)) {
+        if (!wantsLink(device->key())) {
+            m_pending.removeAll(device);
+            device->disconnectFromDevice();
+        } else if (device->status() == TimeularDevice::Disconnected) {
+            enqueue(device);
+        }
+    }
+    if (!m_passive) {
+        const QHash<QString, QBluetoothDeviceInfo> sighted = m_sighted;
+        m_sighted.clear();
+        for (const QBluetoothDeviceInfo &info : sighted)
+            createDevice(info);
+    }
+}
+
+void TimeularPool::promote(const QString &address)
+{
+    if (m_promoted.contains(address))
+        return;
+
+    m_promoted.insert(address);
+    TimeularDevice *device = m_devicesByKey.value(address);
+    if (device) {
+        deviceChanged(device, { PromotedRole });
+        if (device->status() == TimeularDevice::Disconnected)
+            enqueue(device);
+    } else if (m_sighted.contains(address)) {
+        createDevice(m_sighted.take(address));
+    }
+}
+
+void TimeularPool::demote(const QString &address)
+{
+    if (!m_promoted.remove(address))
+        return;
+
+    TimeularDevice *device = m_devicesByKey.value(address);
+    if (device) {
+        deviceChanged(device, { PromotedRole });
+        if (!wantsLink(device->key())) {
+            m_pending.removeAll(device);
+            device->disconnectFromDevice();
+        }
+    }
+}
+
+bool TimeularPool::wantsLink(const QString &key) const
+{
+    return !m_passive || m_promoted.contains(key);
+}
+
+EventRing *TimeularPool::eventRing()
+{
+    return &m_eventRing;
+}
+
+void TimeularPool::startDiscovery()
+{
+    if (m_discovering)
+        return;
+
+    qDebug() << "Starting Discovery";
+    StartupTrace::mark(StartupTrace::DiscoveryStarted);
+    m_discovering = true;
+    emit discoveringChanged(m_discovering);
+    m_scanStarted = m_stats->timestamp();
+    m_adapters->start();
+}
+
+void TimeularPool::stopDiscovery()
+{
+    if (!m_discovering)
+        return;
+
+    m_discovering = false;
+    emit discoveringChanged(m_discovering);
+    m_adapters->stop();
+}
+
+void TimeularPool::addDevice(const QBluetoothDeviceInfo &info, TimeularTransport *transport)
+{
+    const QString key = DeviceCache::deviceKey(info.address(), info.deviceUuid());
+    if (m_devicesByKey.contains(key)) {
+        qWarning() << "Device already in the pool" << key;
+        delete transport;
+        return;
+    }
+
+    TimeularDevice *device = new TimeularDevice(info, transport, this);
+    insertDevice(device);
+    if (wantsLink(device->key()))
+        enqueue(device);
+}
+
+void TimeularPool::createDevice(const QBluetoothDeviceInfo &info)
+{
+    TimeularDevice *device = new TimeularDevice(info, &m_cache, this);
+    insertDevice(device);
+    m_adapters->resetBackoff();
+    enqueue(device);
+}
+
+void TimeularPool::insertDevice(TimeularDevice *device)
+{
+    device->setStats(m_stats);
+    device->setEventRing(&m_eventRing);
+    connect(device, &TimeularDevice::statusChanged,
+            this, [this, device](TimeularDevice::Status status) {
+                deviceStatusChanged(device, status);
+            });
+    connect(device, &TimeularDevice::orientationChanged,
+            this, [this, device]() {
+                deviceChanged(device, { OrientationRole, OrientationTextRole });
+            });
+    connect(device->supervisor(), &LinkSupervisor::recoveryFailed,
+            this, [this, device]() {
+                m_adapters->release(device->key());
+                connectPending();
+            });
+    connect(device, &TimeularDevice::batteryLevelChanged,
+            this, [this, device]() {
+                deviceChanged(device, { BatteryRole });
+            });
+    m_telemetry->addDevice(device);
+
+    beginInsertRows(QModelIndex(), m_devices.size(), m_devices.size());
+    m_devices.append(device);
+    m_devicesByKey.insert(device->key(), device);
+    m_devicesById.insert(device->deviceId(), device);
+    endInsertRows();
+}
+
+void TimeularPool::devicePresenceChanged(quint64 deviceId)
+{
+    TimeularDevice *device = m_devicesById.value(deviceId);
+    if (device)
+        deviceChanged(device, { PresentRole, RssiRole, LastSeenRole });
+}
+
+void TimeularPool::deviceDiscovered(const QBluetoothDeviceInfo &info)
+{
+    if (!TimeularDevice::isTimeularDevice(info))
+        return;
+
+    const QString key = DeviceCache::deviceKey(info.address(), info.deviceUuid());
+    TimeularDevice *device = m_devicesByKey.value(key);
+    if (device) {
+        if (device->status() == TimeularDevice::Disconnected && wantsLink(key)) {
+            m_adapters->resetBackoff();
+            enqueue(device);
+        }
+        return;
+    }
+
+    if (m_stats->isMeasuring() && !m_sighted.contains(key))
+        m_stats->record(TimeularStats::DeviceFound, m_scanStarted);
+    // a die that is only listened for stays in the presence tracker, the
+    // device and its controller are made when it is promoted
+    if (wantsLink(key))
+        createDevice(info);
+    else
+        m_sighted.insert(key, info);
+}
+
+void TimeularPool::deviceStatusChanged(TimeularDevice *device, TimeularDevice::Status status)
+{
+    if (status != TimeularDevice::Connecting)
+        m_inFlight.remove(device);
+
+    const int connectedCount = m_connected.size();
+    if (status == TimeularDevice::Connected) {
+        StartupTrace::mark(StartupTrace::Connected);
+        m_connected.insert(device);
+    } else {
+        m_connected.remove(device);
+    }
+    // a link the supervisor is bringing back keeps its adapter, the retries
+    // don't go through connectPending() to be assigned again
+    if (status == TimeularDevice::Disconnected && !device->supervisor()->isRecovering())
+        m_adapters->release(device->key());
+    else
+        m_adapters->setConnected(device->key(), status == TimeularDevice::Connected);
+    if (m_connected.size() != connectedCount) {
+        if (m_connected.size() < connectedCount)
+            m_adapters->boost();
+        emit connectedCountChanged(m_connected.size());
+    }
+
+    deviceChanged(device, { StatusRole, StatusTextRole, ConnectedRole });
+    if (status != TimeularDevice::Connecting)
+        connectPending();
+}
+
+void TimeularPool::deviceChanged(TimeularDevice *device, const QVector<int> &roles)
+{
+    const int row = m_devices.indexOf(device);
+    if (row < 0)
+        return;
+
+    if (m_updateTimer->interval() == 0) {
+        const QModelIndex idx = index(row);
+        emit dataChanged(idx, idx, roles);
+        return;
+    }
+
+    // a burst of flips only needs the last state of each row
+    QVector<int> &dirty = m_dirtyRows[row];
+    for (int role : roles) {
+        if (!dirty.contains(role))
+            dirty.append(role);
+    }
+    if (!m_updateTimer->isActive())
+        m_updateTimer->start();
+}
+
+void TimeularPool::flushChanges()
+{
+    m_updateTimer->stop();
+    if (m_dirtyRows.isEmpty())
+        return;
+
+    const QMap<int, QVector<int>> dirtyRows = m_dirtyRows;
+    m_dirtyRows.clear();
+
+    // one dataChanged per run of adjacent rows, with the roles of all of them
+    auto it = dirtyRows.constBegin();
+    while (it != dirtyRows.constEnd()) {
+        const int first = it.key();
+        int last = first;
+        QVector<int> roles = it.value();
+        for (++it; it != dirtyRows.constEnd() && it.key() == last + 1; ++it) {
+            last = it.key();
+            for (int role : it.value()) {
+                if (!roles.contains(role))
+                    roles.append(role);
+            }
+        }
+        emit dataChanged(index(first), index(last), roles);
+    }
+}
+
+void TimeularPool::enqueue(TimeularDevice *device)
+{
+    if (m_inFlight.contains(device) || m_pending.contains(device))
+        return;
+
+    m_pending.enqueue(device);
+    connectPending();
+}
+
+void TimeularPool::connectPending()
+{
+    QQueue<TimeularDevice *> deferred;
+    while (m_inFlight.size() < m_maxPendingConnections && !m_pending.isEmpty()) {
+        TimeularDevice *device = m_pending.dequeue();
+        if (device->status() != TimeularDevice::Disconnected)
+            continue;
+
+        const QString key = device->key();
+        if (m_adapters->isSighted(key)) {
+            const int adapter = m_adapters->pick(key);
+            if (adapter < 0) {
+                // waits for a link to free up on an adapter that can hear it
+                deferred.enqueue(device);
+                continue;
+            }
+            m_adapters->assign(key, adapter);
+            device->transport()->setLocalAdapter(m_adapters->address(adapter));
+        }
+
+        qDebug() << "Connecting to device" << key;
+        m_inFlight.insert(device);
+        device->connectToDevice();
+    }
+    m_pending.append(deferred);
+}
@@ -0,0 +1,162 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef TIMEULARPOOL_H
+#define TIMEULARPOOL_H
+
+#include <QAbstractListModel>
+#include <QHash>
+#include <QMap>
+#include <QQueue>
+#include <QSet>
+#include <QVector>
+
+#include "adapterbalancer.h"
+#include "devicecache.h"
+#include "eventring.h"
+#include "presencetracker.h"
+#include "scanscheduler.h"
+#include "telemetryscheduler.h"
+#include "timeulardevice.h"
+#include "timeularstats.h"
+
+class QTimer;
+class TimeularTransport;
+
+class TimeularPool : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(bool discovering READ isDiscovering NOTIFY discoveringChanged)
+    Q_PROPERTY(int maxPendingConnections READ maxPendingConnections WRITE setMaxPendingConnections NOTIFY maxPendingConnectionsChanged)
+    Q_PROPERTY(int connectedCount READ connectedCount NOTIFY connectedCountChanged)
+    Q_PROPERTY(TimeularStats *stats READ stats CONSTANT)
+    Q_PROPERTY(ScanScheduler *scanScheduler READ scanScheduler CONSTANT)
+    Q_PROPERTY(AdapterBalancer *adapters READ adapters CONSTANT)
+    Q_PROPERTY(PresenceTracker *presence READ presence CONSTANT)
+    Q_PROPERTY(TelemetryScheduler *telemetry READ telemetry CONSTANT)
+    Q_PROPERTY(bool passive READ isPassive WRITE setPassive NOTIFY passiveChanged)
+    Q_PROPERTY(int updateInterval READ updateInterval WRITE setUpdateInterval NOTIFY updateIntervalChanged)
+public:
+    enum Roles {
+        AddressRole = Qt::UserRole + 1,
+        NameRole,
+        StatusRole,
+        OrientationRole,
+        StatusTextRole,
+        OrientationTextRole,
+        ConnectedRole,
+        PresentRole,
+        RssiRole,
+        LastSeenRole,
+        PromotedRole,
+        BatteryRole
+    };
+    Q_ENUM(Roles)
+
+    explicit TimeularPool(QObject *parent = nullptr);
+    ~TimeularPool();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    bool isDiscovering() const;
+    int maxPendingConnections() const;
+    void setMaxPendingConnections(int maxPendingConnections);
+    int connectedCount() const;
+    // row changes are collected and reported at most once per interval,
+    // one frame by default, 0 reports every change right away
+    int updateInterval() const;
+    void setUpdateInterval(int msecs);
+    TimeularStats *stats() const;
+    // the first adapter's
+    ScanScheduler *scanScheduler() const;
+    AdapterBalancer *adapters() const;
+    PresenceTracker *presence() const;
+    TelemetryScheduler *telemetry() const;
+
+    // only promoted devices are connected to, the rest are just listened for
+    bool isPassive() const;
+    void setPassive(bool passive);
+    Q_INVOKABLE void promote(const QString &address);
+    Q_INVOKABLE void demote(const QString &address);
+    EventRing *eventRing();
+
+    // adds a device that isn't found by scanning, e.g. a simulated one,
+    // and takes ownership of its transport
+    void addDevice(const QBluetoothDeviceInfo &info, TimeularTransport *transport);
+
+public slots:
+    void startDiscovery();
+    void stopDiscovery();
+    // reports the collected row changes now, e.g. right before a frame is synced
+    void flushChanges();
+
+signals:
+    void discoveringChanged(bool discovering);
+    void maxPendingConnectionsChanged(int maxPendingConnections);
+    void connectedCountChanged(int connectedCount);
+    void passiveChanged(bool passive);
+    void updateIntervalChanged(int msecs);
+
+private:
+    void deviceDiscovered(const QBluetoothDeviceInfo &info);
+    void createDevice(const QBluetoothDeviceInfo &info);
+    void insertDevice(TimeularDevice *device);
+    void devicePresenceChanged(quint64 deviceId);
+    bool wantsLink(const QString &key) const;
+    void deviceStatusChanged(TimeularDevice *device, TimeularDevice::Status status);
+    void deviceChanged(TimeularDevice *device, const QVector<int> &roles);
+    void enqueue(TimeularDevice *device);
+    void connectPending();
+
+    AdapterBalancer *m_adapters = nullptr;
+    PresenceTracker *m_presence = nullptr;
+    TelemetryScheduler *m_telemetry = nullptr;
+    EventRing m_eventRing;
+    DeviceCache m_cache;
+    QVector<TimeularDevice *> m_devices;
+    QHash<QString, TimeularDevice *> m_devicesByKey;
+    QHash<quint64, TimeularDevice *> m_devicesById;
+    QSet<QString> m_promoted;
+    // passive dice heard but not promoted, they aren't rows
+    QHash<QString, QBluetoothDeviceInfo> m_sighted;
+    QQueue<TimeularDevice *> m_pending;
+    QSet<TimeularDevice *> m_inFlight;
+    QSet<TimeularDevice *> m_connected;
+    QMap<int, QVector<int>> m_dirtyRows;
+    QTimer *m_updateTimer = nullptr;
+    int m_maxPendingConnections = 2;
+    bool m_discovering = false;
+    bool m_passive = false;
+    TimeularStats *m_stats = nullptr;
+    qint64 m_scanStarted = 0;
+};
+
+#endif // TIMEULARPOOL_H
@@ -0,0 +1,173 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "timeularstats.h"
+#include "metrics.h"
+#include "processinfo.h"
+
+#include <QMetaEnum>
+#include <QVariantMap>
+
+int LatencyHistogram::bucketFor(qint64 usecs)
+{
+    int bucket = 0;
+    while (usecs > 1 && bucket < BucketCount - 1) {
+        usecs >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+void LatencyHistogram::record(qint64 usecs)
+{
+    usecs = qMax<qint64>(0, usecs);
+    ++m_buckets[bucketFor(usecs)];
+    m_min = m_count ? qMin(m_min, usecs) : usecs;
+    m_max = qMax(m_max, usecs);
+    m_sum += usecs;
+    ++m_count;
+}
+
+void LatencyHistogram::reset()
+{
+    *this = LatencyHistogram();
+}
+
+qint64 LatencyHistogram::percentile(double p) const
+{
+    if (!m_count)
+        return 0;
+
+    const quint64 rank = qMax<quint64>(1, quint64(p * m_count / 100. + 0.5));
+    quint64 seen = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        seen += m_buckets[i];
+        if (seen >= rank)
+            return qMin(m_max, (qint64(1) << (i + 1)) - 1);
+    }
+    return m_max;
+}
+
+TimeularStats::TimeularStats(QObject *parent)
+    : QObject(parent)
+{
+    m_clock.start();
+}
+
+void TimeularStats::setEnabled(bool enabled)
+{
+    if (enabled != m_enabled) {
+        m_enabled = enabled;
+        emit enabledChanged(m_enabled);
+    }
+}
+
+bool TimeularStats::isMeasuring() const
+{
+    return m_enabled || Metrics::isEnabled();
+}
+
+void TimeularStats::record(Phase phase, qint64 since)
+{
+    const qint64 usecs = (timestamp() - since) / 1000;
+    if (m_enabled)
+        m_histograms[phase].record(usecs);
+    Metrics::observe(phase, usecs);
+}
+
+const LatencyHistogram &TimeularStats::histogram(Phase phase) const
+{
+    return m_histograms[phase];
+}
+
+QVariantList TimeularStats::summary() const
+{
+    const QMetaEnum phases = QMetaEnum::fromType<Phase>();
+
+    QVariantList result;
+    for (int i = 0; i < PhaseCount; ++i) {
+        const LatencyHistogram &h = m_histograms[i];
+        QVariantMap entry;
+        entry.insert(QStringLiteral("phase"), QLatin1String(phases.valueToKey(i)));
+        entry.insert(QStringLiteral("count"), h.count());
+        entry.insert(QStringLiteral("min"), h.min());
+        entry.insert(QStringLiteral("mean"), h.mean());
+        entry.insert(QStringLiteral("p50"), h.percentile(50));
+        entry.insert(QStringLiteral("p90"), h.percentile(90));
+        entry.insert(QStringLiteral("p99"), h.percentile(99));
+        entry.insert(QStringLiteral("max"), h.max());
+        result.append(entry);
+    }
+    return result;
+}
+
+QString TimeularStats::report() const
+{
+    const QMetaEnum phases = QMetaEnum::fromType<Phase>();
+
+    QString result;
+    for (int i = 0; i < PhaseCount; ++i) {
+        const LatencyHistogram &h = m_histograms[i];
+        if (!h.count())
+            continue;
+        result += QStringLiteral("%1: n=%2 p50=%3us p90=%4us p99=%5us max=%6us\n")
+                .arg(QLatin1String(phases.valueToKey(i)))
+                .arg(h.count())
+                .arg(h.percentile(50))
+                .arg(h.percentile(90))
+                .arg(h.percentile(99))
+                .arg(h.max());
+    }
+    result += QStringLiteral("memory: rss=%1kB heap=%2kB\n")
+            .arg(ProcessInfo::residentMemory() / 1024)
+            .arg(ProcessInfo::heapInUse() / 1024);
+    if (ProcessInfo::countsAllocations()) {
+        result += QStringLiteral("allocations: total=%1 live=%2\n")
+                .arg(ProcessInfo::allocations())
+                .arg(ProcessInfo::allocations() - ProcessInfo::deallocations());
+    }
+    return result;
+}
+
+QVariantMap TimeularStats::memory() const
+{
+    const quint64 allocations = ProcessInfo::allocations();
+    QVariantMap result;
+    result.insert(QStringLiteral("residentMemory"), ProcessInfo::residentMemory());
+    result.insert(QStringLiteral("heapInUse"), ProcessInfo::heapInUse());
+    result.insert(QStringLiteral("allocations"), allocations);
+    result.insert(QStringLiteral("liveAllocations"), allocations - ProcessInfo::deallocations());
+    return result;
+}
+
+void TimeularStats::reset()
+{
+    for (LatencyHistogram &h : m_histograms)
+        h.reset();
+}
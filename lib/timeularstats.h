@@ -0,0 +1,108 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef TIMEULARSTATS_H
+#define TIMEULARSTATS_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QVariantList>
+#include <QVariantMap>
+
+// Log2 bucketed histogram of durations in microseconds
+class LatencyHistogram
+{
+public:
+    enum { BucketCount = 32 };
+
+    void record(qint64 usecs);
+    void reset();
+
+    static int bucketFor(qint64 usecs);
+
+    quint64 count() const { return m_count; }
+    qint64 min() const { return m_count ? m_min : 0; }
+    qint64 max() const { return m_max; }
+    qint64 mean() const { return m_count ? m_sum / qint64(m_count) : 0; }
+    qint64 percentile(double p) const;
+
+private:
+    quint64 m_buckets[BucketCount] = {};
+    quint64 m_count = 0;
+    qint64 m_sum = 0;
+    qint64 m_min = 0;
+    qint64 m_max = 0;
+};
+
+class TimeularStats : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool enabled READ isEnabled WRITE setEnabled NOTIFY enabledChanged)
+public:
+    enum Phase {
+        DeviceFound,            // since the scan started
+        LinkConnected,          // since the connection attempt started, as are the next ones
+        ServiceDiscovered,
+        DetailsDiscovered,
+        NotificationsEnabled,
+        FirstNotification,
+        FirstOrientation,       // first valid face, read or notified
+        OrientationDelivered,   // time spent in orientationChanged() receivers
+        PhaseCount
+    };
+    Q_ENUM(Phase)
+
+    explicit TimeularStats(QObject *parent = nullptr);
+
+    bool isEnabled() const { return m_enabled; }
+    void setEnabled(bool enabled);
+
+    // enabled, or the metrics histograms are, see Metrics
+    bool isMeasuring() const;
+    qint64 timestamp() const { return m_clock.nsecsElapsed(); }
+    void record(Phase phase, qint64 since);
+    const LatencyHistogram &histogram(Phase phase) const;
+
+    Q_INVOKABLE QVariantList summary() const;
+    Q_INVOKABLE QString report() const;
+    // residentMemory, heapInUse, allocations and liveAllocations, sizes in bytes,
+    // -1 (or 0 for the allocation counts) where unavailable
+    Q_INVOKABLE QVariantMap memory() const;
+    Q_INVOKABLE void reset();
+
+signals:
+    void enabledChanged(bool enabled);
+
+private:
+    QElapsedTimer m_clock;
+    LatencyHistogram m_histograms[PhaseCount];
+    bool m_enabled = false;
+};
+
+#endif // TIMEULARSTATS_H
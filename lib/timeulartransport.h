@@ -0,0 +1,72 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef TIMEULARTRANSPORT_H
+#define TIMEULARTRANSPORT_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QBluetoothAddress>
+#include <QLowEnergyCharacteristic>
+#include <QLowEnergyConnectionParameters>
+
+// The link to a single device underneath TimeularDevice. Implementations
+// report every end of a link, including failed attempts, as disconnected().
+class TimeularTransport : public QObject
+{
+    Q_OBJECT
+public:
+    using QObject::QObject;
+
+    virtual void connectToDevice() = 0;
+    virtual void disconnectFromDevice() = 0;
+    // the value comes back through orientationRead()
+    virtual void readOrientation() = 0;
+    // local adapter for the next connection, a null address for the default one
+    virtual void setLocalAdapter(const QBluetoothAddress &) {}
+    // low priority, the level comes back through batteryRead() if the device has one
+    virtual void readBattery() {}
+    // a request only, the result is reported by connectionParametersChanged()
+    virtual void requestConnectionParameters(const QLowEnergyConnectionParameters &) {}
+
+signals:
+    void connected();
+    void serviceDiscovered();
+    void detailsDiscovered();
+    void subscribed(QLowEnergyHandle orientationHandle);
+    void notificationsEnabled();
+    void disconnected();
+    void notificationReceived(QLowEnergyHandle handle, const QByteArray &value);
+    void orientationRead(QLowEnergyHandle handle, const QByteArray &value);
+    // percent
+    void batteryRead(int level);
+    void connectionParametersChanged(const QLowEnergyConnectionParameters &parameters);
+};
+
+#endif // TIMEULARTRANSPORT_H
@@ -0,0 +1,77 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef ZEIDECODER_H
+#define ZEIDECODER_H
+
+#include <QByteArray>
+#include <QLoggingCategory>
+#include <QLowEnergyCharacteristic>
+
+#include "deviceprofile.h"
+
+Q_DECLARE_LOGGING_CATEGORY(lcZeiDecoder)
+
+// per packet tracing, gone entirely from release builds
+#ifdef QT_NO_DEBUG
+#  define zeiTrace() while (false) QMessageLogger().noDebug()
+#else
+#  define zeiTrace() qCDebug(lcZeiDecoder)
+#endif
+
+template <typename Profile>
+class OrientationDecoder
+{
+public:
+    enum { FaceCount = Profile::faceCount };
+
+    void setOrientationHandle(QLowEnergyHandle handle) { m_orientationHandle = handle; }
+    QLowEnergyHandle orientationHandle() const { return m_orientationHandle; }
+
+    // Returns the face (0 for vertical) carried by a notification, or -1 if
+    // the packet is not an orientation update
+    int decode(QLowEnergyHandle handle, const QByteArray &value) const
+    {
+        if (handle != m_orientationHandle || m_orientationHandle == 0)
+            return -1;
+        if (value.size() <= Profile::faceOffset)
+            return -1;
+
+        const quint8 face = static_cast<quint8>(value.constData()[Profile::faceOffset]);
+        zeiTrace() << "Orientation" << face;
+        return face > FaceCount ? 0 : face;
+    }
+
+private:
+    QLowEnergyHandle m_orientationHandle = 0;
+};
+
+typedef OrientationDecoder<ZeiProfile> ZeiDecoder;
+
+#endif // ZEIDECODER_H
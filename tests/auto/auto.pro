@@ -0,0 +1,11 @@
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    broker \
+    metrics \
+    passivepool \
+    poolupdates \
+    sessionsnapshot \
+    simulation \
+    soak \
+    telemetry
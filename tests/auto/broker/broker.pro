@@ -0,0 +1,6 @@
+TARGET = tst_broker
+
+include(../../tests.pri)
+
+SOURCES += \
+        tst_broker.cpp
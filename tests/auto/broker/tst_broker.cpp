@@ -0,0 +1,182 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <QtTest>
+#include <QLocalServer>
+#include <QLocalSocket>
+
+#include <brokerprotocol.h>
+#include <timeularbrokerclient.h>
+#include <timeularmanager.h>
+
+// The frames a TimeularBroker sends, and a TimeularBrokerClient reading
+// them from a stand-in broker.
+class tst_Broker : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void frames();
+    void unknownFrame();
+    void clientFollowsBroker();
+    void incompatibleBroker();
+
+private:
+    QLocalSocket *acceptClient(TimeularBrokerClient *client);
+
+    QLocalServer *m_server = nullptr;
+    int m_connections = 0;
+};
+
+void tst_Broker::init()
+{
+    const QString name = QStringLiteral("tst_broker-%1").arg(QCoreApplication::applicationPid());
+    QLocalServer::removeServer(name);
+    m_server = new QLocalServer;
+    QVERIFY(m_server->listen(name));
+    m_connections = 0;
+    connect(m_server, &QLocalServer::newConnection, this, [this]() { ++m_connections; });
+}
+
+void tst_Broker::cleanup()
+{
+    delete m_server;
+    m_server = nullptr;
+}
+
+QLocalSocket *tst_Broker::acceptClient(TimeularBrokerClient *client)
+{
+    client->setServerName(m_server->serverName());
+    client->connectToBroker();
+    if (!m_server->waitForNewConnection(5000))
+        return nullptr;
+    return m_server->nextPendingConnection();
+}
+
+void tst_Broker::frames()
+{
+    uchar hello[BrokerProtocol::HelloSize];
+    BrokerProtocol::encodeHello(hello);
+    QCOMPARE(BrokerProtocol::frameSize(hello[0]), int(BrokerProtocol::HelloSize));
+    QVERIFY(BrokerProtocol::validHello(hello));
+
+    uchar status[BrokerProtocol::StatusSize];
+    BrokerProtocol::encodeStatus(Q_UINT64_C(0xc2a500000001), quint8(TimeularManager::Connected), status);
+    QCOMPARE(BrokerProtocol::frameSize(status[0]), int(BrokerProtocol::StatusSize));
+    QCOMPARE(qFromLittleEndian<quint64>(status + 1), Q_UINT64_C(0xc2a500000001));
+    QCOMPARE(int(status[9]), int(TimeularManager::Connected));
+
+    OrientationEvent event;
+    event.timestamp = Q_INT64_C(1700000000123);
+    event.deviceId = Q_UINT64_C(0xc2a500000001);
+    event.face = 7;
+    uchar frame[BrokerProtocol::EventSize];
+    BrokerProtocol::encodeEvent(BrokerProtocol::StableOrientation, event, frame);
+    QCOMPARE(int(frame[0]), int(BrokerProtocol::StableOrientation));
+    QCOMPARE(BrokerProtocol::frameSize(frame[0]), int(BrokerProtocol::EventSize));
+
+    const OrientationEvent decoded = BrokerProtocol::decodeEvent(frame);
+    QCOMPARE(decoded.timestamp, event.timestamp);
+    QCOMPARE(decoded.deviceId, event.deviceId);
+    QCOMPARE(decoded.face, event.face);
+}
+
+void tst_Broker::unknownFrame()
+{
+    QCOMPARE(BrokerProtocol::frameSize(0), 0);
+    QCOMPARE(BrokerProtocol::frameSize(BrokerProtocol::StableOrientation + 1), 0);
+
+    uchar hello[BrokerProtocol::HelloSize];
+    BrokerProtocol::encodeHello(hello);
+    qToLittleEndian<quint16>(BrokerProtocol::Version + 1, hello + 5);
+    QVERIFY(!BrokerProtocol::validHello(hello));
+}
+
+void tst_Broker::clientFollowsBroker()
+{
+    TimeularBrokerClient client;
+    QLocalSocket *broker = acceptClient(&client);
+    QVERIFY(broker);
+
+    QByteArray stream(BrokerProtocol::HelloSize + BrokerProtocol::StatusSize + BrokerProtocol::EventSize, 0);
+    uchar *out = reinterpret_cast<uchar *>(stream.data());
+    BrokerProtocol::encodeHello(out);
+    BrokerProtocol::encodeStatus(Q_UINT64_C(0xc2a500000001), quint8(TimeularManager::Connected),
+                                 out + BrokerProtocol::HelloSize);
+    OrientationEvent event;
+    event.timestamp = Q_INT64_C(1700000000123);
+    event.deviceId = Q_UINT64_C(0xc2a500000001);
+    event.face = 3;
+    BrokerProtocol::encodeEvent(BrokerProtocol::Orientation, event,
+                                out + BrokerProtocol::HelloSize + BrokerProtocol::StatusSize);
+
+    // the event arrives in two pieces
+    broker->write(stream.left(stream.size() - 5));
+    broker->flush();
+    QTRY_COMPARE(client.status(), int(TimeularManager::Connected));
+    QVERIFY(client.isAttached());
+    QCOMPARE(client.deviceId(), Q_UINT64_C(0xc2a500000001));
+    QCOMPARE(client.orientation(), 0);
+
+    broker->write(stream.right(5));
+    broker->flush();
+    QTRY_COMPARE(client.orientation(), 3);
+}
+
+void tst_Broker::incompatibleBroker()
+{
+    TimeularBrokerClient client;
+    QLocalSocket *broker = acceptClient(&client);
+    QVERIFY(broker);
+
+    QByteArray stream(BrokerProtocol::HelloSize + BrokerProtocol::StatusSize, 0);
+    uchar *out = reinterpret_cast<uchar *>(stream.data());
+    BrokerProtocol::encodeHello(out);
+    qToLittleEndian<quint16>(BrokerProtocol::Version + 1, out + 5);
+    BrokerProtocol::encodeStatus(Q_UINT64_C(0xc2a500000001), quint8(TimeularManager::Connected),
+                                 out + BrokerProtocol::HelloSize);
+    broker->write(stream);
+    broker->flush();
+
+    QTRY_COMPARE(broker->state(), QLocalSocket::UnconnectedState);
+    QVERIFY(!client.isAttached());
+    // nothing after the bad hello was read
+    QCOMPARE(client.status(), 0);
+
+    // longer than the retry interval
+    QTest::qWait(1500);
+    QCOMPARE(m_connections, 1);
+}
+
+QTEST_GUILESS_MAIN(tst_Broker)
+
+#include "tst_broker.moc"
@@ -0,0 +1,6 @@
+TARGET = tst_metrics
+
+include(../../tests.pri)
+
+SOURCES += \
+        tst_metrics.cpp
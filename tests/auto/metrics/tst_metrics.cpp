@@ -0,0 +1,245 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <QtTest>
+#include <QTcpSocket>
+
+#include <metrics.h>
+#include <metricsserver.h>
+
+namespace {
+    const char histogram[] = "timeular_phase_duration_seconds";
+
+    struct Sample {
+        QByteArray name;
+        QByteArray labels;
+        double value = 0;
+    };
+
+    // the series in a text exposition, in order, empty if any line is malformed
+    QVector<Sample> parse(const QByteArray &text, QHash<QByteArray, QByteArray> *types)
+    {
+        const QRegularExpression sampleLine(QStringLiteral(
+            "^([a-zA-Z_:][a-zA-Z0-9_:]*)(\\{[^}]*\\})? ([-+]?[0-9.eE+-]+|\\+Inf|NaN)$"));
+        QVector<Sample> samples;
+        for (const QByteArray &line : text.split('\n')) {
+            if (line.isEmpty() || line.startsWith("# HELP "))
+                continue;
+            if (line.startsWith("# TYPE ")) {
+                const QList<QByteArray> fields = line.split(' ');
+                if (fields.size() != 4)
+                    return QVector<Sample>();
+                types->insert(fields.at(2), fields.at(3));
+                continue;
+            }
+
+            const QRegularExpressionMatch match = sampleLine.match(QString::fromLatin1(line));
+            if (!match.hasMatch())
+                return QVector<Sample>();
+            Sample sample;
+            sample.name = match.captured(1).toLatin1();
+            sample.labels = match.captured(2).toLatin1();
+            sample.value = match.captured(3) == QLatin1String("+Inf")
+                    ? qInf() : match.captured(3).toDouble();
+            samples.append(sample);
+        }
+        return samples;
+    }
+
+    QByteArray typeName(const QByteArray &name, const QHash<QByteArray, QByteArray> &types)
+    {
+        for (const char *suffix : { "_bucket", "_sum", "_count" }) {
+            if (name.endsWith(suffix) && types.value(name.left(name.size() - int(qstrlen(suffix)))) == "histogram")
+                return name.left(name.size() - int(qstrlen(suffix)));
+        }
+        return name;
+    }
+}
+
+// The Prometheus exposition and the endpoint serving it
+class tst_Metrics : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void exposition();
+    void histogramBuckets();
+    void serves_data();
+    void serves();
+    void dropsIncompleteRequests_data();
+    void dropsIncompleteRequests();
+
+private:
+    QByteArray fetch(const QByteArray &request);
+
+    MetricsServer m_server;
+};
+
+void tst_Metrics::initTestCase()
+{
+    QVERIFY(m_server.listen(QHostAddress::LocalHost, 0));
+    QVERIFY(Metrics::isEnabled());
+
+    Metrics::add(Metrics::Notifications, 3);
+    // the last one only fits the unbounded bucket
+    const qint64 durations[] = { 0, 1, 500, 1500, 20000, 20000, Q_INT64_C(1) << 40 };
+    for (qint64 usecs : durations)
+        Metrics::observe(TimeularStats::OrientationDelivered, usecs);
+}
+
+QByteArray tst_Metrics::fetch(const QByteArray &request)
+{
+    QTcpSocket socket;
+    QByteArray response;
+    connect(&socket, &QTcpSocket::readyRead, this, [&]() { response += socket.readAll(); });
+    socket.connectToHost(QHostAddress::LocalHost, m_server.port());
+    if (!QTest::qWaitFor([&]() { return socket.state() == QAbstractSocket::ConnectedState; }, 5000))
+        return QByteArray();
+    socket.write(request);
+
+    // every answer ends with the server closing the connection
+    QTest::qWaitFor([&]() { return socket.state() == QAbstractSocket::UnconnectedState; }, 10000);
+    return response + socket.readAll();
+}
+
+void tst_Metrics::exposition()
+{
+    QHash<QByteArray, QByteArray> types;
+    const QVector<Sample> samples = parse(Metrics::exposition(), &types);
+    QVERIFY(!samples.isEmpty());
+
+    bool notifications = false;
+    for (const Sample &sample : samples) {
+        const QByteArray type = types.value(typeName(sample.name, types));
+        QVERIFY2(!type.isEmpty(), sample.name.constData());
+        // counters and only counters are named _total
+        QCOMPARE(type == "counter", sample.name.endsWith("_total"));
+        if (type == "counter")
+            QVERIFY(sample.value >= 0);
+        if (sample.name == "timeular_notifications_total") {
+            QCOMPARE(quint64(sample.value), Metrics::value(Metrics::Notifications));
+            notifications = true;
+        }
+    }
+    QVERIFY(notifications);
+}
+
+void tst_Metrics::histogramBuckets()
+{
+    QHash<QByteArray, QByteArray> types;
+    const QVector<Sample> samples = parse(Metrics::exposition(), &types);
+    QCOMPARE(types.value(histogram), QByteArray("histogram"));
+
+    const QByteArray label = "phase=\"OrientationDelivered\"";
+    const QByteArray bucket = QByteArray(histogram) + "_bucket";
+    double last = 0;
+    double infinite = -1;
+    double count = -1;
+    int buckets = 0;
+    for (const Sample &sample : samples) {
+        if (!sample.labels.contains(label))
+            continue;
+        if (sample.name == bucket) {
+            // cumulative, and +Inf comes last
+            QVERIFY(sample.value >= last);
+            QCOMPARE(infinite, -1.0);
+            last = sample.value;
+            if (sample.labels.contains("le=\"+Inf\""))
+                infinite = sample.value;
+            ++buckets;
+        } else if (sample.name == QByteArray(histogram) + "_count") {
+            count = sample.value;
+        }
+    }
+    QVERIFY(buckets > 1);
+    QCOMPARE(infinite, 7.0);
+    QCOMPARE(count, infinite);
+}
+
+void tst_Metrics::serves_data()
+{
+    QTest::addColumn<QByteArray>("request");
+    QTest::addColumn<QByteArray>("status");
+
+    QTest::newRow("metrics") << QByteArray("GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n")
+                             << QByteArray("200 OK");
+    QTest::newRow("query") << QByteArray("GET /metrics?name=x HTTP/1.1\r\n\r\n")
+                           << QByteArray("200 OK");
+    QTest::newRow("other path") << QByteArray("GET / HTTP/1.1\r\n\r\n")
+                                << QByteArray("404 Not Found");
+    QTest::newRow("post") << QByteArray("POST /metrics HTTP/1.1\r\nContent-Length: 0\r\n\r\n")
+                          << QByteArray("405 Method Not Allowed");
+}
+
+void tst_Metrics::serves()
+{
+    QFETCH(QByteArray, request);
+    QFETCH(QByteArray, status);
+
+    const QByteArray response = fetch(request);
+    QVERIFY2(response.startsWith("HTTP/1.1 " + status + "\r\n"), response.left(64).constData());
+
+    const int headerEnd = response.indexOf("\r\n\r\n");
+    QVERIFY(headerEnd > 0);
+    const QByteArray body = response.mid(headerEnd + 4);
+    QVERIFY(response.left(headerEnd).contains("Content-Length: " + QByteArray::number(body.size())));
+    if (status == "200 OK") {
+        QHash<QByteArray, QByteArray> types;
+        QVERIFY(!parse(body, &types).isEmpty());
+        QCOMPARE(types.value("timeular_resident_memory_bytes"), QByteArray("gauge"));
+    } else {
+        QVERIFY(body.isEmpty());
+    }
+}
+
+void tst_Metrics::dropsIncompleteRequests_data()
+{
+    QTest::addColumn<QByteArray>("request");
+
+    QTest::newRow("nothing") << QByteArray();
+    QTest::newRow("no blank line") << QByteArray("GET /metrics HTTP/1.1\r\nHost: localhost\r\n");
+    QTest::newRow("oversized") << "GET /metrics HTTP/1.1\r\nX-Padding: " + QByteArray(16 * 1024, 'x');
+}
+
+void tst_Metrics::dropsIncompleteRequests()
+{
+    QFETCH(QByteArray, request);
+
+    QElapsedTimer timer;
+    timer.start();
+    // closed by the server, without an answer
+    QCOMPARE(fetch(request), QByteArray());
+    QVERIFY(timer.elapsed() < 10000);
+}
+
+QTEST_GUILESS_MAIN(tst_Metrics)
+
+#include "tst_metrics.moc"
@@ -0,0 +1,6 @@
+TARGET = tst_passivepool
+
+include(../../tests.pri)
+
+SOURCES += \
+        tst_passivepool.cpp
@@ -0,0 +1,138 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <QtTest>
+#include <QBluetoothAddress>
+#include <QBluetoothDeviceInfo>
+
+#include <telemetryscheduler.h>
+#include <timeularpool.h>
+
+namespace {
+    const int deviceCount = 12;
+
+    QBluetoothDeviceInfo dieInfo(int i)
+    {
+        QBluetoothDeviceInfo info(QBluetoothAddress(Q_UINT64_C(0xC2A500000001) + quint64(i)),
+                                  QStringLiteral("Timeular ZEI"), 0);
+        info.setCoreConfigurations(QBluetoothDeviceInfo::LowEnergyCoreConfiguration);
+        info.setRssi(-60);
+        return info;
+    }
+
+    QString dieKey(int i)
+    {
+        const QBluetoothDeviceInfo info = dieInfo(i);
+        return DeviceCache::deviceKey(info.address(), info.deviceUuid());
+    }
+}
+
+// a listen-only pool keeps the dice it hears in the presence tracker and
+// only makes devices for the ones it is asked to connect to
+class tst_PassivePool : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void listensWithoutDevices();
+    void promoteMakesDevice();
+    void leavingPassiveMakesDevices();
+
+private:
+    void sightAll()
+    {
+        for (int i = 0; i < deviceCount; ++i)
+            emit m_pool->adapters()->deviceDiscovered(dieInfo(i));
+    }
+
+    TimeularPool *m_pool = nullptr;
+};
+
+void tst_PassivePool::init()
+{
+    m_pool = new TimeularPool;
+    m_pool->telemetry()->setEnabled(false);
+    m_pool->setUpdateInterval(0);
+    m_pool->setPassive(true);
+}
+
+void tst_PassivePool::cleanup()
+{
+    delete m_pool;
+    m_pool = nullptr;
+}
+
+void tst_PassivePool::listensWithoutDevices()
+{
+    sightAll();
+    sightAll();
+
+    QCOMPARE(m_pool->presence()->presentCount(), deviceCount);
+    QCOMPARE(m_pool->rowCount(), 0);
+    QVERIFY(m_pool->findChildren<TimeularDevice *>().isEmpty());
+}
+
+void tst_PassivePool::promoteMakesDevice()
+{
+    sightAll();
+    QSignalSpy inserted(m_pool, &QAbstractItemModel::rowsInserted);
+
+    m_pool->promote(dieKey(3));
+    QCOMPARE(inserted.count(), 1);
+    QCOMPARE(m_pool->rowCount(), 1);
+    QCOMPARE(m_pool->findChildren<TimeularDevice *>().size(), 1);
+    const QModelIndex idx = m_pool->index(0);
+    QCOMPARE(idx.data(TimeularPool::AddressRole).toString(), dieKey(3));
+    QVERIFY(idx.data(TimeularPool::PromotedRole).toBool());
+    QVERIFY(idx.data(TimeularPool::PresentRole).toBool());
+
+    // heard again, it already has its row
+    sightAll();
+    QCOMPARE(m_pool->rowCount(), 1);
+}
+
+void tst_PassivePool::leavingPassiveMakesDevices()
+{
+    sightAll();
+    m_pool->promote(dieKey(0));
+    QCOMPARE(m_pool->rowCount(), 1);
+
+    m_pool->setPassive(false);
+    QCOMPARE(m_pool->rowCount(), deviceCount);
+
+    sightAll();
+    QCOMPARE(m_pool->rowCount(), deviceCount);
+}
+
+QTEST_GUILESS_MAIN(tst_PassivePool)
+
+#include "tst_passivepool.moc"
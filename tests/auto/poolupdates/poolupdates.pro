@@ -0,0 +1,6 @@
+TARGET = tst_poolupdates
+
+include(../../tests.pri)
+
+SOURCES += \
+        tst_poolupdates.cpp
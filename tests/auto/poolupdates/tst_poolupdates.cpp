@@ -0,0 +1,158 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <QtTest>
+#include <QBluetoothAddress>
+#include <QBluetoothDeviceInfo>
+
+#include <simulatedtransport.h>
+#include <telemetryscheduler.h>
+#include <timeularpool.h>
+
+namespace {
+    const int deviceCount = 3;
+}
+
+// TimeularPool reports row changes in batches, not one by one
+class tst_PoolUpdates : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void coalescesFlips();
+    void mergesAdjacentRows();
+    void flushesOnTimer();
+    void immediateWithoutInterval();
+
+private:
+    void flip(int row)
+    {
+        SimulatedTransport *transport = m_transports.at(row);
+        transport->setFace(transport->face() % 8 + 1);
+    }
+
+    TimeularPool *m_pool = nullptr;
+    QVector<SimulatedTransport *> m_transports;
+};
+
+void tst_PoolUpdates::init()
+{
+    m_pool = new TimeularPool;
+    m_pool->telemetry()->setEnabled(false);
+    m_pool->setMaxPendingConnections(deviceCount);
+    // nothing is reported until a test flushes
+    m_pool->setUpdateInterval(60 * 1000);
+
+    for (int i = 0; i < deviceCount; ++i) {
+        QBluetoothDeviceInfo info(QBluetoothAddress(Q_UINT64_C(0xC2A500000001) + quint64(i)),
+                                  QStringLiteral("Timeular ZEI"), 0);
+        info.setCoreConfigurations(QBluetoothDeviceInfo::LowEnergyCoreConfiguration);
+        SimulatedTransport *transport = new SimulatedTransport;
+        m_transports.append(transport);
+        m_pool->addDevice(info, transport);
+    }
+    QTRY_COMPARE(m_pool->connectedCount(), deviceCount);
+    m_pool->flushChanges();
+}
+
+void tst_PoolUpdates::cleanup()
+{
+    delete m_pool;
+    m_pool = nullptr;
+    m_transports.clear();
+}
+
+void tst_PoolUpdates::coalescesFlips()
+{
+    QSignalSpy spy(m_pool, &QAbstractItemModel::dataChanged);
+    for (int i = 0; i < 100; ++i)
+        flip(0);
+    QCOMPARE(spy.count(), 0);
+
+    m_pool->flushChanges();
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).toModelIndex().row(), 0);
+    QCOMPARE(spy.at(0).at(1).toModelIndex().row(), 0);
+    const QVector<int> roles = spy.at(0).at(2).value<QVector<int>>();
+    QVERIFY(roles.contains(TimeularPool::OrientationRole));
+
+    // nothing left over
+    m_pool->flushChanges();
+    QCOMPARE(spy.count(), 1);
+}
+
+void tst_PoolUpdates::mergesAdjacentRows()
+{
+    QSignalSpy spy(m_pool, &QAbstractItemModel::dataChanged);
+    flip(0);
+    flip(1);
+    m_pool->flushChanges();
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).toModelIndex().row(), 0);
+    QCOMPARE(spy.at(0).at(1).toModelIndex().row(), 1);
+
+    spy.clear();
+    flip(2);
+    flip(0);
+    m_pool->flushChanges();
+    QCOMPARE(spy.count(), 2);
+    QCOMPARE(spy.at(0).at(0).toModelIndex().row(), 0);
+    QCOMPARE(spy.at(0).at(1).toModelIndex().row(), 0);
+    QCOMPARE(spy.at(1).at(0).toModelIndex().row(), 2);
+    QCOMPARE(spy.at(1).at(1).toModelIndex().row(), 2);
+}
+
+void tst_PoolUpdates::flushesOnTimer()
+{
+    m_pool->setUpdateInterval(16);
+    QSignalSpy spy(m_pool, &QAbstractItemModel::dataChanged);
+    for (int i = 0; i < 100; ++i)
+        flip(i % deviceCount);
+    QCOMPARE(spy.count(), 0);
+
+    QTRY_COMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).toModelIndex().row(), 0);
+    QCOMPARE(spy.at(0).at(1).toModelIndex().row(), deviceCount - 1);
+}
+
+void tst_PoolUpdates::immediateWithoutInterval()
+{
+    m_pool->setUpdateInterval(0);
+    QSignalSpy spy(m_pool, &QAbstractItemModel::dataChanged);
+    for (int i = 0; i < 10; ++i)
+        flip(0);
+    QCOMPARE(spy.count(), 10);
+}
+
+QTEST_GUILESS_MAIN(tst_PoolUpdates)
+
+#include "tst_poolupdates.moc"
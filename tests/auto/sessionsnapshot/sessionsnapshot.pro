@@ -0,0 +1,6 @@
+TARGET = tst_sessionsnapshot
+
+include(../../tests.pri)
+
+SOURCES += \
+        tst_sessionsnapshot.cpp
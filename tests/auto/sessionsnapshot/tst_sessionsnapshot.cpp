@@ -0,0 +1,218 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <QtTest>
+
+#include <faceaggregator.h>
+#include <sessionlog.h>
+#include <sessionsnapshot.h>
+
+namespace {
+    const quint64 firstDevice = Q_UINT64_C(0xc2a500000001);
+    const quint64 secondDevice = Q_UINT64_C(0xc2a500000002);
+    const int recordCount = 40;
+    const int snapshotRecords = 25;
+}
+
+// Snapshots only stand in for the part of the log they were taken from
+class tst_SessionSnapshot : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+
+    void restoresMatchingLog();
+    void rejectsShorterLog();
+    void rejectsOtherHistory();
+    void rejectsGarbage();
+    void rejectsTruncated();
+    void rejectsHugeCounts_data();
+    void rejectsHugeCounts();
+
+private:
+    void writeLog(int records, qint64 start);
+    bool writeSnapshot(int records);
+
+    QTemporaryDir m_dir;
+    QString m_log;
+    qint64 m_start = 0;
+};
+
+void tst_SessionSnapshot::init()
+{
+    QVERIFY(m_dir.isValid());
+    m_log = m_dir.filePath(QStringLiteral("session.log"));
+    QFile::remove(m_log);
+    QFile::remove(SessionSnapshot::fileName(m_log));
+    // an hour ago, inside the two days the totals are compared over
+    m_start = QDateTime::currentMSecsSinceEpoch() - 60 * 60 * 1000;
+    writeLog(recordCount, m_start);
+}
+
+void tst_SessionSnapshot::writeLog(int records, qint64 start)
+{
+    QFile::remove(m_log);
+    SessionLogWriter writer;
+    QVERIFY(writer.open(m_log));
+    for (int i = 0; i < records; ++i) {
+        OrientationEvent event;
+        event.timestamp = start + i * 60 * 1000;
+        event.deviceId = i % 3 ? firstDevice : secondDevice;
+        event.face = quint8(i % 8 + 1);
+        writer.append(event);
+    }
+    writer.close();
+}
+
+bool tst_SessionSnapshot::writeSnapshot(int records)
+{
+    SessionLogReader reader;
+    if (!reader.open(m_log))
+        return false;
+
+    FaceAggregator aggregator;
+    for (int i = 0; i < records; ++i)
+        aggregator.addEvent(reader.at(i));
+    return SessionSnapshot::write(m_log, records, reader.at(records - 1).timestamp, aggregator);
+}
+
+void tst_SessionSnapshot::restoresMatchingLog()
+{
+    QVERIFY(writeSnapshot(snapshotRecords));
+
+    SessionLogReader reader;
+    QVERIFY(reader.open(m_log));
+    FaceAggregator restored;
+    QCOMPARE(SessionSnapshot::read(m_log, reader, &restored), qint64(snapshotRecords));
+    restored.load(reader, snapshotRecords);
+
+    FaceAggregator replayed;
+    replayed.load(reader);
+
+    const qint64 today = replayed.today();
+    QCOMPARE(restored.rowCount(), replayed.rowCount());
+    for (quint64 device : { firstDevice, secondDevice }) {
+        for (int face = 0; face < FaceAggregator::FaceCount; ++face)
+            QCOMPARE(restored.duration(device, face, today - 1, today),
+                     replayed.duration(device, face, today - 1, today));
+    }
+    QCOMPARE(restored.lastEvent().timestamp, replayed.lastEvent().timestamp);
+}
+
+void tst_SessionSnapshot::rejectsShorterLog()
+{
+    QVERIFY(writeSnapshot(snapshotRecords));
+    writeLog(snapshotRecords - 1, m_start);
+
+    SessionLogReader reader;
+    QVERIFY(reader.open(m_log));
+    FaceAggregator aggregator;
+    QCOMPARE(SessionSnapshot::read(m_log, reader, &aggregator), qint64(-1));
+    QCOMPARE(aggregator.rowCount(), 0);
+}
+
+void tst_SessionSnapshot::rejectsOtherHistory()
+{
+    QVERIFY(writeSnapshot(snapshotRecords));
+    // as many records, but not the ones the snapshot was taken from
+    writeLog(recordCount, m_start + 1000);
+
+    SessionLogReader reader;
+    QVERIFY(reader.open(m_log));
+    FaceAggregator aggregator;
+    QCOMPARE(SessionSnapshot::read(m_log, reader, &aggregator), qint64(-1));
+    QCOMPARE(aggregator.rowCount(), 0);
+}
+
+void tst_SessionSnapshot::rejectsGarbage()
+{
+    QFile file(SessionSnapshot::fileName(m_log));
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("not a snapshot");
+    file.close();
+
+    SessionLogReader reader;
+    QVERIFY(reader.open(m_log));
+    FaceAggregator aggregator;
+    QCOMPARE(SessionSnapshot::read(m_log, reader, &aggregator), qint64(-1));
+}
+
+void tst_SessionSnapshot::rejectsTruncated()
+{
+    QVERIFY(writeSnapshot(snapshotRecords));
+    QFile file(SessionSnapshot::fileName(m_log));
+    const qint64 size = file.size();
+
+    SessionLogReader reader;
+    QVERIFY(reader.open(m_log));
+    for (qint64 cut = size - 1; cut > 0; cut -= 7) {
+        QVERIFY(file.resize(cut));
+        FaceAggregator aggregator;
+        QCOMPARE(SessionSnapshot::read(m_log, reader, &aggregator), qint64(-1));
+        QCOMPARE(aggregator.rowCount(), 0);
+    }
+}
+
+void tst_SessionSnapshot::rejectsHugeCounts_data()
+{
+    QTest::addColumn<int>("events");
+
+    // the count is the last field written either way
+    QTest::newRow("devices") << 0;
+    QTest::newRow("days") << 1;
+}
+
+void tst_SessionSnapshot::rejectsHugeCounts()
+{
+    QFETCH(int, events);
+
+    SessionLogReader reader;
+    QVERIFY(reader.open(m_log));
+    FaceAggregator saved;
+    for (int i = 0; i < events; ++i)
+        saved.addEvent(reader.at(i));
+    QVERIFY(SessionSnapshot::write(m_log, events, events ? reader.at(events - 1).timestamp : 0, saved));
+
+    QFile file(SessionSnapshot::fileName(m_log));
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.seek(file.size() - 4));
+    const uchar huge[] = { 0x7f, 0xff, 0xff, 0xff };
+    QCOMPARE(file.write(reinterpret_cast<const char *>(huge), sizeof(huge)), qint64(sizeof(huge)));
+    file.close();
+
+    // rejected up front, not after trying to allocate for 2^31 entries
+    FaceAggregator aggregator;
+    QCOMPARE(SessionSnapshot::read(m_log, reader, &aggregator), qint64(-1));
+    QCOMPARE(aggregator.rowCount(), 0);
+}
+
+QTEST_GUILESS_MAIN(tst_SessionSnapshot)
+
+#include "tst_sessionsnapshot.moc"
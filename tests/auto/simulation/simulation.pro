@@ -0,0 +1,6 @@
+TARGET = tst_simulation
+
+include(../../tests.pri)
+
+SOURCES += \
+        tst_simulation.cpp
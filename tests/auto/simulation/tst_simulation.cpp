@@ -0,0 +1,90 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <QtTest>
+
+#include <eventring.h>
+#include <metrics.h>
+#include <simulator.h>
+#include <timeularpool.h>
+
+namespace {
+    const int deviceCount = 4;
+}
+
+// A pool of simulated dice under flips and dropped links, the way
+// timeulard --simulate --drop-rate runs it.
+class tst_Simulation : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void lossyLinks();
+};
+
+void tst_Simulation::lossyLinks()
+{
+    TimeularPool pool;
+    pool.setMaxPendingConnections(deviceCount);
+
+    Simulator simulator;
+    simulator.setConnectLatency(0);
+    simulator.attach(&pool, deviceCount);
+    QTRY_COMPARE(pool.connectedCount(), deviceCount);
+
+    const quint64 lostBefore = Metrics::value(Metrics::LinksLost);
+    const quint64 restoredBefore = Metrics::value(Metrics::LinksRestored);
+    const quint64 failedBefore = Metrics::value(Metrics::RecoveriesFailed);
+    const quint64 changesBefore = Metrics::value(Metrics::OrientationChanges);
+    const quint64 publishedBefore = pool.eventRing()->published();
+
+    simulator.setRate(2000);
+    simulator.setDropRate(50);
+    simulator.start();
+    QTest::qWait(1500);
+    simulator.stop();
+
+    // every link comes back through its supervisor, none via discovery
+    QTRY_COMPARE(pool.connectedCount(), deviceCount);
+    const quint64 lost = Metrics::value(Metrics::LinksLost) - lostBefore;
+    QVERIFY(lost > 0);
+    QVERIFY(lost <= simulator.dropped());
+    QTRY_COMPARE(Metrics::value(Metrics::LinksRestored) - restoredBefore, lost);
+    QCOMPARE(Metrics::value(Metrics::RecoveriesFailed) - failedBefore, quint64(0));
+
+    // flips while a link was down are lost, each connect may add the face it read
+    const quint64 published = pool.eventRing()->published() - publishedBefore;
+    QCOMPARE(published, Metrics::value(Metrics::OrientationChanges) - changesBefore);
+    QVERIFY(published > 0);
+    QVERIFY(published <= simulator.generated() + lost + deviceCount);
+}
+
+QTEST_GUILESS_MAIN(tst_Simulation)
+
+#include "tst_simulation.moc"
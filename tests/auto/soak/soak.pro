@@ -0,0 +1,6 @@
+TARGET = tst_soak
+
+include(../../tests.pri)
+
+SOURCES += \
+        tst_soak.cpp
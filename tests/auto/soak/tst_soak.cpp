@@ -0,0 +1,107 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <QtTest>
+#include <QBluetoothAddress>
+#include <QBluetoothDeviceInfo>
+
+#include <processinfo.h>
+#include <simulatedtransport.h>
+#include <timeularpool.h>
+
+namespace {
+    // TIMEULAR_SOAK_CYCLES overrides it for longer or quicker runs
+    const int defaultCycles = 100000;
+    const int warmupCycles = 1000;
+
+    // room for allocator noise, not for anything kept per cycle
+    const qint64 maxHeapGrowth = 256 * 1024;
+    const qint64 maxResidentGrowth = 2 * 1024 * 1024;
+}
+
+// Drops and restores one simulated link over and over, with a face change
+// per cycle, and checks that memory stays where it was after warming up.
+class tst_Soak : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void reconnectCycles();
+};
+
+void tst_Soak::initTestCase()
+{
+    // two lines per cycle otherwise
+    QLoggingCategory::setFilterRules(QStringLiteral("default.debug=false"));
+}
+
+void tst_Soak::reconnectCycles()
+{
+    const int total = qMax(warmupCycles + 1, qEnvironmentVariableIsSet("TIMEULAR_SOAK_CYCLES")
+                           ? qEnvironmentVariableIntValue("TIMEULAR_SOAK_CYCLES") : defaultCycles);
+
+    QBluetoothDeviceInfo info(QBluetoothAddress(Q_UINT64_C(0xC2A500000001)), QStringLiteral("Timeular ZEI"), 0);
+    info.setCoreConfigurations(QBluetoothDeviceInfo::LowEnergyCoreConfiguration);
+
+    TimeularPool pool;
+    SimulatedTransport *transport = new SimulatedTransport;
+
+    int cycles = 0;
+    qint64 heapBefore = 0;
+    qint64 residentBefore = 0;
+    connect(transport, &TimeularTransport::notificationsEnabled, this, [&]() {
+        transport->setFace(cycles % 8 + 1);
+        if (++cycles == warmupCycles) {
+            heapBefore = ProcessInfo::heapInUse();
+            residentBefore = ProcessInfo::residentMemory();
+        }
+        // the supervisor reconnects straight away
+        if (cycles < total)
+            QMetaObject::invokeMethod(transport, [transport]() { transport->dropLink(); }, Qt::QueuedConnection);
+    });
+    pool.addDevice(info, transport);
+
+    QTRY_VERIFY_WITH_TIMEOUT(cycles >= total, 5 * 60 * 1000);
+    QCOMPARE(pool.connectedCount(), 1);
+
+    const qint64 heapAfter = ProcessInfo::heapInUse();
+    const qint64 residentAfter = ProcessInfo::residentMemory();
+    qInfo().nospace() << total << " cycles, heap " << heapBefore / 1024 << " -> " << heapAfter / 1024
+                      << " kB, resident memory " << residentBefore / 1024 << " -> " << residentAfter / 1024 << " kB";
+
+    if (heapAfter >= 0)
+        QVERIFY2(heapAfter - heapBefore < maxHeapGrowth, "Heap grew with the reconnects");
+    if (residentAfter >= 0)
+        QVERIFY2(residentAfter - residentBefore < maxResidentGrowth, "Resident memory grew with the reconnects");
+}
+
+QTEST_GUILESS_MAIN(tst_Soak)
+
+#include "tst_soak.moc"
@@ -0,0 +1,6 @@
+TARGET = tst_telemetry
+
+include(../../tests.pri)
+
+SOURCES += \
+        tst_telemetry.cpp
@@ -0,0 +1,135 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <QtTest>
+#include <QBluetoothAddress>
+#include <QBluetoothDeviceInfo>
+
+#include <simulatedtransport.h>
+#include <telemetryscheduler.h>
+#include <timeulardevice.h>
+
+// Battery reads scheduled by TelemetryScheduler on simulated links
+class tst_Telemetry : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void quietLinkRead();
+    void busyLinkDeferred();
+    void oneReadPerInterval();
+
+private:
+    TimeularDevice *addDevice(int batteryLevel);
+
+    TelemetryScheduler *m_scheduler = nullptr;
+    QVector<SimulatedTransport *> m_transports;
+    QVector<TimeularDevice *> m_devices;
+};
+
+void tst_Telemetry::init()
+{
+    m_scheduler = new TelemetryScheduler;
+    // the shortest the scheduler allows
+    m_scheduler->setInterval(1000);
+    m_scheduler->setQuietTime(0);
+}
+
+void tst_Telemetry::cleanup()
+{
+    qDeleteAll(m_devices);
+    m_devices.clear();
+    m_transports.clear();
+    delete m_scheduler;
+    m_scheduler = nullptr;
+}
+
+TimeularDevice *tst_Telemetry::addDevice(int batteryLevel)
+{
+    QBluetoothDeviceInfo info(QBluetoothAddress(Q_UINT64_C(0xC2A500000001) + quint64(m_devices.size())),
+                              QStringLiteral("Timeular ZEI"), 0);
+    info.setCoreConfigurations(QBluetoothDeviceInfo::LowEnergyCoreConfiguration);
+
+    SimulatedTransport *transport = new SimulatedTransport;
+    transport->setBatteryLevel(batteryLevel);
+    TimeularDevice *device = new TimeularDevice(info, transport);
+    m_transports.append(transport);
+    m_devices.append(device);
+
+    m_scheduler->addDevice(device);
+    device->connectToDevice();
+    return device;
+}
+
+void tst_Telemetry::quietLinkRead()
+{
+    TimeularDevice *device = addDevice(80);
+    QCOMPARE(device->batteryLevel(), -1);
+
+    QTRY_COMPARE(device->batteryLevel(), 80);
+    QCOMPARE(m_scheduler->reads(), quint64(1));
+
+    // not due again for another battery period
+    QTest::qWait(2 * m_scheduler->interval());
+    QCOMPARE(m_scheduler->reads(), quint64(1));
+}
+
+void tst_Telemetry::busyLinkDeferred()
+{
+    m_scheduler->setQuietTime(60 * 1000);
+    TimeularDevice *device = addDevice(80);
+    QTRY_COMPARE(device->status(), TimeularDevice::Connected);
+    m_transports.first()->setFace(2);
+
+    QTRY_VERIFY(m_scheduler->deferred() > 0);
+    QCOMPARE(m_scheduler->reads(), quint64(0));
+    QCOMPARE(device->batteryLevel(), -1);
+}
+
+void tst_Telemetry::oneReadPerInterval()
+{
+    TimeularDevice *first = addDevice(80);
+    TimeularDevice *second = addDevice(60);
+
+    QTRY_COMPARE(m_scheduler->reads(), quint64(1));
+    // the answer arrives a little later
+    QTRY_COMPARE(int(first->batteryLevel() >= 0) + int(second->batteryLevel() >= 0), 1);
+    QCOMPARE(m_scheduler->reads(), quint64(1));
+
+    QTRY_COMPARE(m_scheduler->reads(), quint64(2));
+    QTRY_COMPARE(first->batteryLevel(), 80);
+    QCOMPARE(second->batteryLevel(), 60);
+}
+
+QTEST_GUILESS_MAIN(tst_Telemetry)
+
+#include "tst_telemetry.moc"
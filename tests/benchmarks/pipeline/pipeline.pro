@@ -0,0 +1,7 @@
+TARGET = tst_bench_pipeline
+CONFIG += benchmark count_allocations
+
+include(../../tests.pri)
+
+SOURCES += \
+        tst_bench_pipeline.cpp
@@ -0,0 +1,215 @@
+/*
+  Copyright 2019 Mike Krus
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in
+     the documentation and/or other materials provided with the
+     distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <QtTest>
+#include <QBluetoothAddress>
+#include <QBluetoothDeviceInfo>
+
+#include <eventring.h>
+#include <processinfo.h>
+#include <simulatedtransport.h>
+#include <timeulardevice.h>
+#include <zeidecoder.h>
+
+namespace {
+    // events per measurement outside QBENCHMARK
+    const int batchSize = 100000;
+}
+
+// The notification path from the transport to orientationChanged(), fed by a
+// synthetic stream of face changes, and the connection state machine, both
+// without any radio in the loop.
+class tst_BenchPipeline : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void notificationLatency();
+    void notificationThroughput();
+    void allocationsPerEvent();
+    void connectCycle();
+
+    void decode_data();
+    void decode();
+
+private:
+    // every call is a face change, so every event makes it all the way through
+    void flip()
+    {
+        m_face = m_face % 8 + 1;
+        m_transport->setFace(m_face);
+    }
+
+    EventRing m_ring;
+    SimulatedTransport *m_transport = nullptr;
+    TimeularDevice *m_device = nullptr;
+    quint64 m_delivered = 0;
+    int m_face = 0;
+};
+
+void tst_BenchPipeline::initTestCase()
+{
+    // debug builds trace every packet, that isn't what is being measured
+    QLoggingCategory::setFilterRules(QStringLiteral("timeular.decoder.debug=false"));
+}
+
+void tst_BenchPipeline::init()
+{
+    QBluetoothDeviceInfo info(QBluetoothAddress(Q_UINT64_C(0xC2A500000001)), QStringLiteral("Timeular ZEI"), 0);
+    info.setCoreConfigurations(QBluetoothDeviceInfo::LowEnergyCoreConfiguration);
+
+    m_transport = new SimulatedTransport;
+    m_device = new TimeularDevice(info, m_transport);
+    m_device->setEventRing(&m_ring);
+    // one consumer, as the manager would be
+    connect(m_device, &TimeularDevice::orientationChanged,
+            this, [this]() { ++m_delivered; });
+
+    m_device->connectToDevice();
+    QTRY_COMPARE(m_device->status(), TimeularDevice::Connected);
+    m_delivered = 0;
+}
+
+void tst_BenchPipeline::cleanup()
+{
+    delete m_device;
+    m_device = nullptr;
+    m_transport = nullptr;
+}
+
+void tst_BenchPipeline::notificationLatency()
+{
+    // time per iteration is the latency of one event
+    QBENCHMARK {
+        flip();
+    }
+    QVERIFY(m_delivered > 0);
+}
+
+void tst_BenchPipeline::notificationThroughput()
+{
+    QElapsedTimer timer;
+    QBENCHMARK_ONCE {
+        timer.start();
+        for (int i = 0; i < batchSize; ++i)
+            flip();
+    }
+    const qint64 nsecs = qMax<qint64>(1, timer.nsecsElapsed());
+    QCOMPARE(m_delivered, quint64(batchSize));
+
+    qInfo().nospace() << batchSize << " events in " << nsecs / 1000 << " us, "
+                      << qint64(batchSize * 1e9 / nsecs) << " events/s";
+}
+
+void tst_BenchPipeline::allocationsPerEvent()
+{
+    if (!ProcessInfo::countsAllocations())
+        QSKIP("Needs CONFIG+=count_allocations");
+
+    // let containers along the path reach their steady size first
+    for (int i = 0; i < 1000; ++i)
+        flip();
+
+    const quint64 before = ProcessInfo::allocations();
+    for (int i = 0; i < batchSize; ++i)
+        flip();
+    const quint64 allocations = ProcessInfo::allocations() - before;
+
+    qInfo() << "Allocations per event" << double(allocations) / batchSize;
+    // from the notification to the ring and orientationChanged(), nothing may allocate
+    QCOMPARE(allocations, quint64(0));
+}
+
+void tst_BenchPipeline::connectCycle()
+{
+    m_device->disconnectFromDevice();
+    QCOMPARE(m_device->status(), TimeularDevice::Disconnected);
+
+    quint64 cycles = 0;
+    quint64 subscriptions = 0;
+    connect(m_transport, &TimeularTransport::notificationsEnabled,
+            this, [&subscriptions]() { ++subscriptions; });
+
+    // connect, service and details discovery, the CCCD write and a
+    // disconnect per iteration
+    QBENCHMARK {
+        m_device->connectToDevice();
+        QCOMPARE(m_device->status(), TimeularDevice::Connecting);
+
+        // the transport comes up on the next pass of the event loop, QTRY_
+        // and qWaitFor() would sleep in between
+        QElapsedTimer timeout;
+        timeout.start();
+        while (m_device->status() == TimeularDevice::Connecting && timeout.elapsed() < 5000)
+            QCoreApplication::processEvents();
+        QCOMPARE(m_device->status(), TimeularDevice::Connected);
+
+        m_device->disconnectFromDevice();
+        ++cycles;
+    }
+    QCOMPARE(m_device->status(), TimeularDevice::Disconnected);
+    QCOMPARE(subscriptions, cycles);
+}
+
+void tst_BenchPipeline::decode_data()
+{
+    QTest::addColumn<int>("handle");
+    QTest::addColumn<QByteArray>("value");
+    QTest::addColumn<int>("expected");
+
+    QTest::newRow("valid") << 0x25 << QByteArray(1, 3) << 3;
+    QTest::newRow("wrong handle") << 0x28 << QByteArray(1, 3) << -1;
+    QTest::newRow("short") << 0x25 << QByteArray() << -1;
+}
+
+void tst_BenchPipeline::decode()
+{
+    QFETCH(int, handle);
+    QFETCH(QByteArray, value);
+    QFETCH(int, expected);
+
+    ZeiDecoder decoder;
+    decoder.setOrientationHandle(0x25);
+    QCOMPARE(decoder.decode(QLowEnergyHandle(handle), value), expected);
+
+    // time per iteration is the cost of one packet
+    volatile int face = 0;
+    QBENCHMARK {
+        face = decoder.decode(QLowEnergyHandle(handle), value);
+    }
+    Q_UNUSED(face)
+}
+
+QTEST_GUILESS_MAIN(tst_BenchPipeline)
+
+#include "tst_bench_pipeline.moc"
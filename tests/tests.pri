@@ -0,0 +1,11 @@
+# Shared by every test and benchmark executable
+QT = core testlib
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+include($$PWD/../common.pri)
+include($$PWD/../lib/lib.pri)
+
+# builds ProcessInfo with the allocation counting operator new into the
+# executable itself, it takes precedence over the library's copy
+count_allocations: SOURCES += $$PWD/../lib/processinfo.cpp
@@ -0,0 +1,6 @@
+TEMPLATE = subdirs
+
+# make check runs the tests, make benchmark the benchmarks
+SUBDIRS += \
+    auto \
+    benchmarks